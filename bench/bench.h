@@ -0,0 +1,282 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: Minimal benchmark harness shared by the benchmarks
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Results are printed to stdout, one row per measurement, as CSV
+ * (default) or JSON lines when the environment variable
+ * PRICK_BENCH_FORMAT is "json".  Each benchmark declares its own
+ * columns with bench_begin; the harness appends ns_total and
+ * ns_per_op to every row.
+ *
+ * PRICK_BENCH_MAX_BYTES bounds the memory any one measurement may
+ * use (default 1 GiB), so large sizes are skipped rather than
+ * swapping.
+ *
+ * When PRICK_BENCH_PERF is set (Linux only), hardware and software
+ * counters are read with perf_event_open around every measurement
+ * and reported per operation after the timings.  Counters the kernel
+ * won't give us (e.g. in containers, or with a strict
+ * perf_event_paranoid) are left empty (CSV) or null (JSON) rather than
+ * failing the run.
+ */
+
+#define BENCH_DEFAULT_MAX_BYTES (1UL << 30)
+
+#define BENCH_COUNTERS 6
+
+static const char *const bench_counter_names[BENCH_COUNTERS] = {
+    "cycles",      "instructions", "l1d_misses",
+    "llc_misses",  "dtlb_misses",  "page_faults",
+};
+
+typedef struct
+{
+  uint64_t ns; // total time measured
+  uint64_t t0;
+  uint64_t counts[BENCH_COUNTERS]; // total counted
+  uint64_t c0[BENCH_COUNTERS];
+} bench_measure_t;
+
+typedef struct
+{
+  char text[64];
+  int quoted;
+} bench_val_t;
+
+static const char *const *bench_cols;
+static size_t bench_ncols;
+static int bench_json;
+static int bench_perf;                     // whether counters are wanted
+static int bench_perf_fds[BENCH_COUNTERS]; // -1 if unavailable
+
+#ifdef __linux__
+static inline int bench_perf_open(uint32_t type, uint64_t config,
+                                  int exclude_kernel)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size           = sizeof(attr);
+  attr.type           = type;
+  attr.config         = config;
+  attr.exclude_kernel = exclude_kernel;
+  attr.exclude_hv     = 1;
+  attr.inherit        = 1; // count threads the benchmark spawns
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#define BENCH_CACHE_MISS(CACHE)                                           \
+  ((CACHE) | (PERF_COUNT_HW_CACHE_OP_READ << 8) |                         \
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+#endif
+
+static inline void bench_perf_init(void)
+{
+  for (size_t i = 0; i < BENCH_COUNTERS; ++i)
+    bench_perf_fds[i] = -1;
+  bench_perf = getenv("PRICK_BENCH_PERF") != NULL;
+  if (!bench_perf)
+    return;
+#ifdef __linux__
+  bench_perf_fds[0] = bench_perf_open(PERF_TYPE_HARDWARE,
+                                      PERF_COUNT_HW_CPU_CYCLES, 1);
+  bench_perf_fds[1] = bench_perf_open(PERF_TYPE_HARDWARE,
+                                      PERF_COUNT_HW_INSTRUCTIONS, 1);
+  bench_perf_fds[2] = bench_perf_open(
+      PERF_TYPE_HW_CACHE, BENCH_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D), 1);
+  bench_perf_fds[3] = bench_perf_open(
+      PERF_TYPE_HW_CACHE, BENCH_CACHE_MISS(PERF_COUNT_HW_CACHE_LL), 1);
+  bench_perf_fds[4] = bench_perf_open(
+      PERF_TYPE_HW_CACHE, BENCH_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB), 1);
+  // Page faults are handled in the kernel, so don't exclude it
+  bench_perf_fds[5] = bench_perf_open(PERF_TYPE_SOFTWARE,
+                                      PERF_COUNT_SW_PAGE_FAULTS, 0);
+#endif
+  for (size_t i = 0; i < BENCH_COUNTERS; ++i)
+    if (bench_perf_fds[i] < 0)
+      fprintf(stderr, "perf counter %s unavailable, leaving it empty\n",
+              bench_counter_names[i]);
+}
+
+// Reads every counter, scaled up if the kernel had to multiplex it
+static inline void bench_perf_read(uint64_t *counts)
+{
+  for (size_t i = 0; i < BENCH_COUNTERS; ++i)
+  {
+    counts[i] = 0;
+#ifdef __linux__
+    uint64_t value[3]; // value, time enabled, time running
+    if (bench_perf_fds[i] < 0 ||
+        read(bench_perf_fds[i], value, sizeof(value)) != sizeof(value))
+      continue;
+    counts[i] = value[2] ? (uint64_t)((double)value[0] * (double)value[1] /
+                                      (double)value[2])
+                         : 0;
+#endif
+  }
+}
+
+static inline uint64_t bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline size_t bench_max_bytes(void)
+{
+  const char *env = getenv("PRICK_BENCH_MAX_BYTES");
+  return env ? (size_t)strtoull(env, NULL, 10) : BENCH_DEFAULT_MAX_BYTES;
+}
+
+// Whether a measurement needing bytes of memory fits in the budget
+static inline int bench_fits(size_t bytes)
+{
+  if (bytes <= bench_max_bytes())
+    return 1;
+  fprintf(stderr, "skipping: %zu bytes is over PRICK_BENCH_MAX_BYTES\n",
+          bytes);
+  return 0;
+}
+
+// Number of repetitions so that reps * n is at least min_ops
+static inline size_t bench_reps(size_t n, size_t min_ops)
+{
+  return n >= min_ops ? 1 : (min_ops + n - 1) / n;
+}
+
+// Stops the compiler from eliding work whose result is only in memory
+static inline void bench_clobber(void *ptr)
+{
+  __asm__ volatile("" : : "g"(ptr) : "memory");
+}
+
+static inline void bench_begin(const char *const *cols, size_t ncols)
+{
+  const char *format = getenv("PRICK_BENCH_FORMAT");
+  bench_json         = format && strcmp(format, "json") == 0;
+  bench_cols         = cols;
+  bench_ncols        = ncols;
+  bench_perf_init();
+  if (bench_json)
+    return;
+  for (size_t i = 0; i < ncols; ++i)
+    printf("%s,", cols[i]);
+  printf("ns_total,ns_per_op");
+  if (bench_perf)
+    for (size_t i = 0; i < BENCH_COUNTERS; ++i)
+      printf(",%s_per_op", bench_counter_names[i]);
+  printf("\n");
+  fflush(stdout);
+}
+
+// Counters are read outside of the timed section, so reading them
+// costs nothing in ns but does add a little to the counts themselves
+static inline void bench_start(bench_measure_t *m)
+{
+  if (bench_perf)
+    bench_perf_read(m->c0);
+  m->t0 = bench_now();
+}
+
+static inline void bench_stop(bench_measure_t *m)
+{
+  m->ns += bench_now() - m->t0;
+  if (!bench_perf)
+    return;
+  uint64_t c1[BENCH_COUNTERS];
+  bench_perf_read(c1);
+  for (size_t i = 0; i < BENCH_COUNTERS; ++i)
+    m->counts[i] += c1[i] - m->c0[i];
+}
+
+static inline bench_val_t bench_u(uint64_t x)
+{
+  bench_val_t val;
+  val.quoted = 0;
+  snprintf(val.text, sizeof(val.text), "%llu", (unsigned long long)x);
+  return val;
+}
+
+static inline bench_val_t bench_f(double x)
+{
+  bench_val_t val;
+  val.quoted = 0;
+  snprintf(val.text, sizeof(val.text), "%.3f", x);
+  return val;
+}
+
+static inline bench_val_t bench_s(const char *x)
+{
+  bench_val_t val;
+  val.quoted = 1;
+  snprintf(val.text, sizeof(val.text), "%s", x);
+  return val;
+}
+
+/**
+ * Prints a row made of one value per column given to bench_begin,
+ * followed by the time measured in total and per operation, then
+ * (with PRICK_BENCH_PERF) each counter per operation.
+ */
+static inline void bench_row(const bench_val_t *vals,
+                             const bench_measure_t *m, size_t ops)
+{
+  double per_op = ops ? (double)m->ns / (double)ops : 0;
+  if (bench_json)
+  {
+    printf("{");
+    for (size_t i = 0; i < bench_ncols; ++i)
+      printf(vals[i].quoted ? "\"%s\": \"%s\", " : "\"%s\": %s, ",
+             bench_cols[i], vals[i].text);
+    printf("\"ns_total\": %llu, \"ns_per_op\": %.3f",
+           (unsigned long long)m->ns, per_op);
+    for (size_t i = 0; bench_perf && i < BENCH_COUNTERS; ++i)
+      if (bench_perf_fds[i] < 0 || !ops)
+        printf(", \"%s_per_op\": null", bench_counter_names[i]);
+      else
+        printf(", \"%s_per_op\": %.3f", bench_counter_names[i],
+               (double)m->counts[i] / (double)ops);
+    printf("}\n");
+  }
+  else
+  {
+    for (size_t i = 0; i < bench_ncols; ++i)
+      printf("%s,", vals[i].text);
+    printf("%llu,%.3f", (unsigned long long)m->ns, per_op);
+    for (size_t i = 0; bench_perf && i < BENCH_COUNTERS; ++i)
+      if (bench_perf_fds[i] < 0 || !ops)
+        printf(",");
+      else
+        printf(",%.3f", (double)m->counts[i] / (double)ops);
+    printf("\n");
+  }
+  fflush(stdout);
+}
+
+#endif
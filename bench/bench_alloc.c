@@ -0,0 +1,130 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: Append throughput with a bump arena against libc
+ */
+
+#define PRICK_DARR_IMPLEMENTATION
+#include "../prick_darr.h"
+#include "bench.h"
+
+#define ARRAYS  1024
+#define MIN_OPS (1 << 24)
+
+typedef struct
+{
+  uint8_t *base;
+  size_t used, size;
+  uint8_t *last; // most recent allocation, which can grow in place
+} arena_t;
+
+static void *arena_alloc(void *ctx, size_t size)
+{
+  arena_t *arena = (arena_t *)ctx;
+  size           = (size + 15) & ~(size_t)15;
+  if (arena->used + size > arena->size)
+    return NULL;
+  arena->last = arena->base + arena->used;
+  arena->used += size;
+  return arena->last;
+}
+
+static void *arena_realloc(void *ctx, void *ptr, size_t old_size,
+                           size_t new_size)
+{
+  arena_t *arena = (arena_t *)ctx;
+  if (ptr == arena->last)
+  {
+    size_t end = (size_t)(arena->last - arena->base) +
+                 ((new_size + 15) & ~(size_t)15);
+    if (end > arena->size)
+      return NULL;
+    arena->used = end;
+    return ptr;
+  }
+  void *new_ptr = arena_alloc(ctx, new_size);
+  if (new_ptr)
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+  return new_ptr;
+}
+
+static void arena_free(void *ctx, void *ptr, size_t size)
+{
+  (void)ctx;
+  (void)ptr;
+  (void)size;
+}
+
+static const prick_darr_allocator_t arena_allocator = {
+    .alloc   = arena_alloc,
+    .realloc = arena_realloc,
+    .free    = arena_free,
+};
+
+static prick_darr_t arrays[ARRAYS];
+
+// Appends n members to each of ARRAYS arrays, round robin so that
+// growth of one array interleaves with the others as it would with
+// many live arrays
+static void run(const prick_darr_allocator_t *allocator, arena_t *arena,
+                size_t size, size_t n)
+{
+  static uint8_t element[64];
+  for (size_t a = 0; a < ARRAYS; ++a)
+    prick_darr_init_allocator(arrays + a, size, allocator, arena);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t a = 0; a < ARRAYS; ++a)
+      prick_darr_append(arrays + a, element);
+  for (size_t a = 0; a < ARRAYS; ++a)
+  {
+    bench_clobber(arrays[a].data);
+    prick_darr_free(arrays + a, NULL);
+  }
+}
+
+int main(void)
+{
+  static const char *const cols[] = {"bench", "allocator", "elem_size", "n",
+                                     "ops"};
+  static const size_t sizes[]     = {4, 8, 64};
+  bench_begin(cols, sizeof(cols) / sizeof(cols[0]));
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    for (size_t n = 1; n <= 100000; n *= 10)
+    {
+      size_t size = sizes[s], reps = bench_reps(n * ARRAYS, MIN_OPS);
+      // Every growth step of every array stays in the arena
+      arena_t arena = {.size = 4 * ARRAYS * (n + 16) * size + ARRAYS * 64};
+      if (!bench_fits(arena.size))
+        continue;
+      arena.base = (uint8_t *)malloc(arena.size);
+
+      bench_measure_t m = {0};
+      bench_start(&m);
+      for (size_t r = 0; r < reps; ++r)
+        run(NULL, NULL, size, n);
+      bench_stop(&m);
+      bench_val_t libc[] = {bench_s("alloc"), bench_s("libc"), bench_u(size),
+                            bench_u(n), bench_u(reps * n * ARRAYS)};
+      bench_row(libc, &m, reps * n * ARRAYS);
+
+      m = (bench_measure_t){0};
+      bench_start(&m);
+      for (size_t r = 0; r < reps; ++r)
+      {
+        arena.used = 0;
+        arena.last = NULL;
+        run(&arena_allocator, &arena, size, n);
+      }
+      bench_stop(&m);
+      bench_val_t bump[] = {bench_s("alloc"), bench_s("arena"), bench_u(size),
+                            bench_u(n), bench_u(reps * n * ARRAYS)};
+      bench_row(bump, &m, reps * n * ARRAYS);
+      free(arena.base);
+    }
+  return 0;
+}
@@ -0,0 +1,219 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: Benchmarks of the core prick_darr.h operations
+ */
+
+#define PRICK_DARR_IMPLEMENTATION
+#include "../prick_darr.h"
+#include "bench.h"
+
+// Enough operations per measurement to drown out timer overhead
+#define MIN_OPS (1 << 22)
+// Largest batch handed to the _n functions at once
+#define BATCH 1024
+
+static const size_t elem_sizes[] = {1, 4, 8, 16, 64, 256};
+static uint8_t element[BATCH * 256];
+
+static void fill(prick_darr_t *darr, size_t size, size_t n)
+{
+  prick_darr_init(darr, size);
+  prick_darr_ensure_capacity(darr, n);
+  for (size_t i = 0; i < n; i += BATCH)
+    prick_darr_append_n(darr, element, n - i < BATCH ? n - i : BATCH);
+}
+
+static void report_as(const char *bench, const char *op, size_t size,
+                      size_t n, const bench_measure_t *m, size_t ops)
+{
+  bench_val_t vals[] = {bench_s(bench), bench_s(op), bench_u(size),
+                        bench_u(n), bench_u(ops)};
+  bench_row(vals, m, ops);
+}
+
+static void report(const char *op, size_t size, size_t n,
+                   const bench_measure_t *m, size_t ops)
+{
+  report_as("darr", op, size, n, m, ops);
+}
+
+static void bench_size(size_t size, size_t n)
+{
+  size_t reps = bench_reps(n, MIN_OPS);
+  prick_darr_t darr;
+  bench_measure_t m;
+
+  m = (bench_measure_t){0};
+  bench_start(&m);
+  for (size_t r = 0; r < reps; ++r)
+  {
+    prick_darr_init(&darr, size);
+    for (size_t i = 0; i < n; ++i)
+      prick_darr_append(&darr, element);
+    bench_clobber(darr.data);
+    prick_darr_free(&darr, NULL);
+  }
+  bench_stop(&m);
+  report("append", size, n, &m, reps * n);
+
+  m = (bench_measure_t){0};
+  bench_start(&m);
+  for (size_t r = 0; r < reps; ++r)
+  {
+    prick_darr_init(&darr, size);
+    for (size_t i = 0; i < n; i += BATCH)
+      prick_darr_append_n(&darr, element, n - i < BATCH ? n - i : BATCH);
+    bench_clobber(darr.data);
+    prick_darr_free(&darr, NULL);
+  }
+  bench_stop(&m);
+  report("append_n", size, n, &m, reps * n);
+
+  fill(&darr, size, n);
+  m = (bench_measure_t){0};
+  bench_start(&m);
+  for (size_t r = 0; r < reps; ++r)
+    for (size_t i = 0; i < n; ++i)
+      prick_darr_write(&darr, element, i);
+  bench_clobber(darr.data);
+  bench_stop(&m);
+  report("write", size, n, &m, reps * n);
+
+  m = (bench_measure_t){0};
+  bench_start(&m);
+  for (size_t r = 0; r < reps; ++r)
+    for (size_t i = 0; i < n; i += BATCH)
+      prick_darr_write_n(&darr, element, n - i < BATCH ? n - i : BATCH, i);
+  bench_clobber(darr.data);
+  bench_stop(&m);
+  report("write_n", size, n, &m, reps * n);
+  prick_darr_free(&darr, NULL);
+
+  // The remaining operations are one call per array, so measure
+  // enough arrays to make the timing meaningful
+  reps = bench_reps(n, MIN_OPS) < 4096 ? bench_reps(n, MIN_OPS) : 4096;
+
+  m = (bench_measure_t){0};
+  for (size_t r = 0; r < reps; ++r)
+  {
+    prick_darr_init_lazy(&darr, size);
+    bench_start(&m);
+    prick_darr_ensure_capacity(&darr, n);
+    bench_stop(&m);
+    prick_darr_free(&darr, NULL);
+  }
+  report("ensure_capacity", size, n, &m, reps);
+
+  m = (bench_measure_t){0};
+  for (size_t r = 0; r < reps; ++r)
+  {
+    fill(&darr, size, n);
+    prick_darr_erase_range(&darr, n / 2, n - (n / 2));
+    bench_start(&m);
+    prick_darr_tighten(&darr);
+    bench_stop(&m);
+    prick_darr_free(&darr, NULL);
+  }
+  report("tighten", size, n, &m, reps);
+
+  m = (bench_measure_t){0};
+  for (size_t r = 0; r < reps; ++r)
+  {
+    fill(&darr, size, n);
+    bench_start(&m);
+    prick_darr_free(&darr, NULL);
+    bench_stop(&m);
+  }
+  report("free", size, n, &m, reps);
+}
+
+PRICK_DARR_DEFINE(uint64_t, u64)
+
+// Typed pushes and a summing loop through a u64_t (struct then data
+// pointer) against a fat pointer (data directly)
+static void bench_fat(size_t n)
+{
+  size_t reps = bench_reps(n, MIN_OPS);
+  bench_measure_t m;
+  uint64_t sum = 0;
+
+  u64_t arr;
+  m = (bench_measure_t){0};
+  bench_start(&m);
+  for (size_t r = 0; r < reps; ++r)
+  {
+    u64_init(&arr);
+    for (size_t i = 0; i < n; ++i)
+      u64_push(&arr, i);
+    bench_clobber(u64_data(&arr));
+    u64_free(&arr);
+  }
+  bench_stop(&m);
+  report_as("darr", "push_u64", sizeof(uint64_t), n, &m, reps * n);
+
+  uint64_t *fat = NULL;
+  m = (bench_measure_t){0};
+  bench_start(&m);
+  for (size_t r = 0; r < reps; ++r)
+  {
+    for (size_t i = 0; i < n; ++i)
+      PRICK_DARR_FAT_PUSH(fat, i);
+    bench_clobber(fat);
+    PRICK_DARR_FAT_FREE(fat);
+  }
+  bench_stop(&m);
+  report_as("fat", "push_u64", sizeof(uint64_t), n, &m, reps * n);
+
+  u64_init(&arr);
+  for (size_t i = 0; i < n; ++i)
+    u64_push(&arr, i);
+  u64_t *parr = &arr;
+  bench_clobber(&parr);
+  m = (bench_measure_t){0};
+  bench_start(&m);
+  for (size_t r = 0; r < reps; ++r)
+  {
+    for (size_t i = 0; i < u64_len(parr); ++i)
+      sum += *u64_at(parr, i);
+    bench_clobber(parr);
+  }
+  bench_stop(&m);
+  report_as("darr", "sum_u64", sizeof(uint64_t), n, &m, reps * n);
+  u64_free(&arr);
+
+  for (size_t i = 0; i < n; ++i)
+    PRICK_DARR_FAT_PUSH(fat, i);
+  m = (bench_measure_t){0};
+  bench_start(&m);
+  for (size_t r = 0; r < reps; ++r)
+  {
+    for (size_t i = 0; i < PRICK_DARR_FAT_LEN(fat); ++i)
+      sum += fat[i];
+    bench_clobber(fat);
+  }
+  bench_stop(&m);
+  report_as("fat", "sum_u64", sizeof(uint64_t), n, &m, reps * n);
+  PRICK_DARR_FAT_FREE(fat);
+  bench_clobber(&sum);
+}
+
+int main(void)
+{
+  static const char *const cols[] = {"bench", "op", "elem_size", "n", "ops"};
+  bench_begin(cols, sizeof(cols) / sizeof(cols[0]));
+  for (size_t s = 0; s < sizeof(elem_sizes) / sizeof(elem_sizes[0]); ++s)
+    for (size_t n = 10; n <= 1000000000; n *= 10)
+      // Growth may briefly hold two copies of the array
+      if (bench_fits(2 * n * elem_sizes[s]))
+        bench_size(elem_sizes[s], n);
+  for (size_t n = 10; n <= 1000000000; n *= 10)
+    if (bench_fits(2 * n * sizeof(uint64_t)))
+      bench_fat(n);
+  return 0;
+}
@@ -0,0 +1,126 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: Peak RSS and bytes copied for each growth policy, with
+ * and without filling malloc's slack (PRICK_DARR_FLAG_EXACT)
+ */
+
+#define PRICK_DARR_STATS
+#define PRICK_DARR_IMPLEMENTATION
+#include "../prick_darr.h"
+#include "bench.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define SIZE  8
+#define BATCH 256
+
+typedef struct
+{
+  prick_darr_stats_t stats;
+  size_t available;
+  bench_measure_t m;
+} result_t;
+
+static size_t grow_eighth(size_t used, size_t requested, size_t available)
+{
+  (void)available;
+  return used + requested + (used + requested) / 8;
+}
+
+static const struct
+{
+  const char *name;
+  prick_darr_growth_t growth;
+} policies[] = {
+    {"mult2", {.kind = PRICK_DARR_GROWTH_MULT, .factor = 2}},
+    {"mult1.5", {.kind = PRICK_DARR_GROWTH_MULT, .factor = 1.5}},
+    {"add64k", {.kind = PRICK_DARR_GROWTH_ADD, .step = 1 << 16}},
+    {"fn_eighth", {.kind = PRICK_DARR_GROWTH_FN, .fn = grow_eighth}},
+};
+
+// Runs in a child process so its peak RSS is its own
+static void child(int fd, const prick_darr_growth_t *growth, int exact,
+                  size_t n)
+{
+  static uint8_t element[BATCH * SIZE];
+  result_t result = {0};
+  prick_darr_t darr;
+  bench_start(&result.m);
+  prick_darr_init_lazy(&darr, SIZE);
+  if (exact)
+    darr.flags |= PRICK_DARR_FLAG_EXACT;
+  prick_darr_set_growth(&darr, growth);
+  for (size_t i = 0; i < n; i += BATCH)
+    prick_darr_append_n(&darr, element, n - i < BATCH ? n - i : BATCH);
+  bench_stop(&result.m);
+  result.stats     = darr.stats;
+  result.available = darr.available;
+  if (write(fd, &result, sizeof(result)) != sizeof(result))
+    _exit(1);
+  _exit(0);
+}
+
+// Runs one policy in a child process and prints its row
+static int measure(size_t p, int exact, size_t n)
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+    return 1;
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    close(fds[0]);
+    child(fds[1], &policies[p].growth, exact, n);
+  }
+  close(fds[1]);
+  result_t result;
+  struct rusage usage;
+  int status;
+  ssize_t got = read(fds[0], &result, sizeof(result));
+  close(fds[0]);
+  if (wait4(pid, &status, 0, &usage) < 0 || got != sizeof(result))
+    return 1;
+  bench_val_t vals[] = {
+      bench_s("growth"),
+      bench_s(policies[p].name),
+      bench_s(exact ? "exact" : "usable"),
+      bench_u(n),
+      bench_u(result.stats.grows),
+      bench_u(result.stats.bytes_allocated),
+      bench_u(result.stats.bytes_copied),
+      bench_u(result.stats.peak_available),
+      bench_u(result.available * SIZE),
+      bench_u((uint64_t)usage.ru_maxrss),
+  };
+  bench_row(vals, &result.m, n);
+  return 0;
+}
+
+int main(void)
+{
+  static const char *const cols[] = {"bench",          "policy",
+                                     "slack",          "n",
+                                     "grows",          "bytes_allocated",
+                                     "bytes_copied",   "peak_available",
+                                     "final_available", "peak_rss_kib"};
+  bench_begin(cols, sizeof(cols) / sizeof(cols[0]));
+  for (size_t n = 1000; n <= 1000000000; n *= 10)
+  {
+    if (!bench_fits(2 * n * SIZE))
+      break;
+    // "exact" is the capacity the policy asks for, "usable" also
+    // fills malloc's slack
+    for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); ++p)
+      if (measure(p, 1, n) || measure(p, 0, n))
+        return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: Streaming many dynamic arrays to a pipe, one write per
+ * array against one gathered writev (and vmsplice on Linux)
+ */
+
+#define _GNU_SOURCE
+#define PRICK_DARR_IMPLEMENTATION
+#include "../prick_darr.h"
+#include "bench.h"
+
+#include <sys/wait.h>
+
+#define SIZE 16
+// Bytes streamed per measurement
+#define TOTAL (64 << 20)
+
+typedef enum
+{
+  WRITE_EACH,
+  GATHER,
+  VMSPLICE,
+} variant_t;
+
+static const char *const variant_names[] = {"write_fd", "write_fd_many",
+                                            "vmsplice_fd"};
+
+// Reads the pipe until EOF, discarding everything
+static void drain(int fd)
+{
+  static uint8_t buffer[1 << 16];
+  while (read(fd, buffer, sizeof(buffer)) > 0)
+    continue;
+  _exit(0);
+}
+
+static int measure(variant_t variant, size_t arrays)
+{
+  size_t members = TOTAL / SIZE / arrays;
+  static uint8_t element[SIZE];
+  prick_darr_t *darrs = (prick_darr_t *)malloc(arrays * sizeof(*darrs));
+  for (size_t i = 0; i < arrays; ++i)
+  {
+    prick_darr_init_lazy(&darrs[i], SIZE);
+    for (size_t j = 0; j < members; ++j)
+      prick_darr_append(&darrs[i], element);
+  }
+
+  int fds[2];
+  if (pipe(fds) != 0)
+    return 1;
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    close(fds[1]);
+    drain(fds[0]);
+  }
+  close(fds[0]);
+
+  bench_measure_t m = {0};
+  ssize_t wrote     = 0;
+  bench_start(&m);
+  switch (variant)
+  {
+  case WRITE_EACH:
+    for (size_t i = 0; i < arrays; ++i)
+      wrote += prick_darr_write_fd(&darrs[i], fds[1], 0, darrs[i].used);
+    break;
+  case GATHER:
+    wrote = prick_darr_write_fd_many(darrs, arrays, fds[1]);
+    break;
+  case VMSPLICE:
+#ifdef PRICK_DARR_HAS_VMSPLICE
+    for (size_t i = 0; i < arrays; ++i)
+      wrote += prick_darr_vmsplice_fd(&darrs[i], fds[1], 0, darrs[i].used);
+#endif
+    break;
+  }
+  close(fds[1]);
+  // The storage may only be freed once the reader is done with it
+  waitpid(pid, NULL, 0);
+  bench_stop(&m);
+
+  bench_val_t vals[] = {bench_s("io"), bench_s(variant_names[variant]),
+                        bench_u(arrays), bench_u((uint64_t)wrote)};
+  bench_row(vals, &m, arrays);
+  for (size_t i = 0; i < arrays; ++i)
+    prick_darr_free(&darrs[i], NULL);
+  free(darrs);
+  return 0;
+}
+
+int main(void)
+{
+  static const char *const cols[] = {"bench", "op", "arrays", "bytes"};
+  bench_begin(cols, sizeof(cols) / sizeof(cols[0]));
+  if (!bench_fits(2 * TOTAL))
+    return 0;
+  for (size_t arrays = 1; arrays <= 65536; arrays *= 16)
+  {
+    if (measure(WRITE_EACH, arrays) || measure(GATHER, arrays))
+      return 1;
+#ifdef PRICK_DARR_HAS_VMSPLICE
+    if (measure(VMSPLICE, arrays))
+      return 1;
+#endif
+  }
+  return 0;
+}
@@ -0,0 +1,140 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: Append tail latency for each way of growing storage
+ */
+
+#define _GNU_SOURCE
+#define PRICK_DARR_IMPLEMENTATION
+#include "../prick_darr.h"
+#include "bench.h"
+
+#define SIZE    8
+#define BUCKETS 64
+
+typedef enum
+{
+  REALLOC,
+  VMEM,
+  MREMAP,
+  INCREMENTAL,
+} variant_t;
+
+static const char *const variant_names[] = {"realloc", "vmem", "mremap",
+                                            "incremental"};
+
+// Latencies histogrammed by log2 of nanoseconds
+typedef struct
+{
+  uint64_t buckets[BUCKETS];
+  uint64_t count, max;
+} histogram_t;
+
+static void record(histogram_t *hist, uint64_t ns)
+{
+  size_t bucket = 0;
+  while (bucket < BUCKETS - 1 && ((uint64_t)1 << bucket) < ns)
+    ++bucket;
+  ++hist->buckets[bucket];
+  ++hist->count;
+  hist->max = ns > hist->max ? ns : hist->max;
+}
+
+// Upper bound of the bucket holding the given quantile
+static uint64_t quantile(const histogram_t *hist, double q)
+{
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < BUCKETS; ++bucket)
+  {
+    seen += hist->buckets[bucket];
+    if ((double)seen >= q * (double)hist->count)
+      return (uint64_t)1 << bucket;
+  }
+  return hist->max;
+}
+
+static void run(variant_t variant, size_t n)
+{
+  static histogram_t hist;
+  uint64_t element = 0;
+  prick_darr_t darr;
+  prick_darr_inc_t inc;
+  bench_measure_t m = {0};
+  memset(&hist, 0, sizeof(hist));
+
+  switch (variant)
+  {
+  case REALLOC:
+    prick_darr_init(&darr, SIZE);
+    break;
+  case VMEM:
+#ifdef PRICK_DARR_HAS_MMAP
+    prick_darr_init_vmem(&darr, SIZE, n);
+#endif
+    break;
+  case MREMAP:
+#ifdef PRICK_DARR_HAS_MREMAP
+    prick_darr_init_mremap(&darr, SIZE, 0);
+#endif
+    break;
+  case INCREMENTAL:
+    prick_darr_inc_init(&inc, SIZE);
+    break;
+  }
+
+  bench_start(&m);
+  for (size_t i = 0; i < n; ++i, ++element)
+  {
+    uint64_t t0 = bench_now();
+    if (variant == INCREMENTAL)
+      prick_darr_inc_append(&inc, &element);
+    else
+      prick_darr_append(&darr, &element);
+    record(&hist, bench_now() - t0);
+  }
+  bench_stop(&m);
+
+  if (variant == INCREMENTAL)
+    prick_darr_inc_free(&inc, NULL);
+  else
+    prick_darr_free(&darr, NULL);
+
+  bench_val_t vals[] = {
+      bench_s("latency"),
+      bench_s(variant_names[variant]),
+      bench_u(n),
+      bench_u(quantile(&hist, 0.5)),
+      bench_u(quantile(&hist, 0.99)),
+      bench_u(quantile(&hist, 0.999)),
+      bench_u(hist.max),
+  };
+  bench_row(vals, &m, n);
+}
+
+int main(void)
+{
+  static const char *const cols[] = {"bench",   "variant", "n",     "p50_ns",
+                                     "p99_ns", "p999_ns", "max_ns"};
+  static const size_t sizes[]     = {1000000, 100000000, 1000000000};
+  bench_begin(cols, sizeof(cols) / sizeof(cols[0]));
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+  {
+    // Growth by copy briefly holds both the old and new storage
+    if (!bench_fits(3 * sizes[s] * SIZE))
+      continue;
+    run(REALLOC, sizes[s]);
+#ifdef PRICK_DARR_HAS_MMAP
+    run(VMEM, sizes[s]);
+#endif
+#ifdef PRICK_DARR_HAS_MREMAP
+    run(MREMAP, sizes[s]);
+#endif
+    run(INCREMENTAL, sizes[s]);
+  }
+  return 0;
+}
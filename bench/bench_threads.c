@@ -0,0 +1,116 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: Scaling of appends from many threads into one array
+ */
+
+#define PRICK_DARR_IMPLEMENTATION
+#define PRICK_DARR_THREADS
+#include "../prick_darr.h"
+#define PRICK_SARR_IMPLEMENTATION
+#include "../prick_sarr.h"
+#include "bench.h"
+
+#include <pthread.h>
+
+#define SIZE        8
+#define TOTAL       (1 << 24)
+#define MAX_THREADS 64
+
+typedef enum
+{
+  MUTEX,
+  ATOMIC,
+  STAGED,
+} variant_t;
+
+static const char *const variant_names[] = {"mutex", "atomic", "staged"};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static prick_darr_t darr;
+static prick_sarr_t sarr;
+static prick_darr_t stages[MAX_THREADS];
+
+typedef struct
+{
+  variant_t variant;
+  size_t id, n;
+} job_t;
+
+static void *worker(void *arg)
+{
+  job_t *job       = (job_t *)arg;
+  uint64_t element = job->id;
+  for (size_t i = 0; i < job->n; ++i)
+    switch (job->variant)
+    {
+    case MUTEX:
+      pthread_mutex_lock(&lock);
+      prick_darr_append(&darr, &element);
+      pthread_mutex_unlock(&lock);
+      break;
+    case ATOMIC:
+      prick_sarr_append_atomic(&sarr, &element);
+      break;
+    case STAGED:
+      prick_darr_append(stages + job->id, &element);
+      break;
+    }
+  return NULL;
+}
+
+static void run(variant_t variant, size_t threads)
+{
+  pthread_t handles[MAX_THREADS];
+  job_t jobs[MAX_THREADS];
+  bench_measure_t m = {0};
+
+  prick_darr_init(&darr, SIZE);
+  prick_sarr_init(&sarr, SIZE);
+  prick_darr_init_stages(stages, threads, SIZE);
+
+  bench_start(&m);
+  for (size_t t = 0; t < threads; ++t)
+  {
+    jobs[t] = (job_t){.variant = variant, .id = t, .n = TOTAL / threads};
+    pthread_create(handles + t, NULL, worker, jobs + t);
+  }
+  for (size_t t = 0; t < threads; ++t)
+    pthread_join(handles[t], NULL);
+  if (variant == STAGED)
+    prick_darr_merge(&darr, stages, threads);
+  bench_stop(&m);
+
+  prick_darr_free(&darr, NULL);
+  prick_sarr_free(&sarr, NULL);
+  for (size_t t = 0; t < threads; ++t)
+    prick_darr_free(stages + t, NULL);
+
+  size_t ops         = (TOTAL / threads) * threads;
+  bench_val_t vals[] = {bench_s("threads"), bench_s(variant_names[variant]),
+                        bench_u(threads), bench_u(ops)};
+  bench_row(vals, &m, ops);
+}
+
+int main(int argc, char *argv[])
+{
+  static const char *const cols[] = {"bench", "variant", "threads", "ops"};
+  size_t max_threads              = argc > 1
+                                        ? (size_t)strtoul(argv[1], NULL, 10)
+                                        : (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+  if (max_threads > MAX_THREADS)
+    max_threads = MAX_THREADS;
+  bench_begin(cols, sizeof(cols) / sizeof(cols[0]));
+  for (size_t threads = 1; threads <= max_threads; threads *= 2)
+  {
+    run(MUTEX, threads);
+    run(ATOMIC, threads);
+    run(STAGED, threads);
+  }
+  return 0;
+}
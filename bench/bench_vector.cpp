@@ -0,0 +1,108 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: prick::darr<T> against std::vector<T>
+ */
+
+#define PRICK_DARR_IMPLEMENTATION
+#include "../prick_darr.hpp"
+#include "bench.h"
+
+#include <string>
+#include <vector>
+
+#define MIN_OPS (1 << 24)
+
+struct record
+{
+  uint64_t fields[8];
+};
+
+template <typename T>
+T make(size_t i);
+
+template <>
+int make<int>(size_t i)
+{
+  return (int)i;
+}
+
+template <>
+record make<record>(size_t i)
+{
+  return record{{i, i, i, i, i, i, i, i}};
+}
+
+template <>
+std::string make<std::string>(size_t i)
+{
+  // Long enough to not fit in the small string buffer
+  return std::string(32, (char)('a' + i % 26));
+}
+
+template <typename Container>
+static void run(const char *container, const char *type, size_t n)
+{
+  using T     = typename Container::value_type;
+  size_t reps = bench_reps(n, MIN_OPS);
+  bench_measure_t m;
+  const char *ops[] = {"push_back", "reserve_push_back", "iterate"};
+
+  for (size_t op = 0; op < 3; ++op)
+  {
+    m = bench_measure_t{};
+    for (size_t r = 0; r < reps; ++r)
+    {
+      Container c;
+      if (op == 2)
+        for (size_t i = 0; i < n; ++i)
+          c.push_back(make<T>(i));
+      bench_start(&m);
+      if (op == 1)
+        c.reserve(n);
+      if (op < 2)
+        for (size_t i = 0; i < n; ++i)
+          c.push_back(make<T>(i));
+      else
+      {
+        size_t sum = 0;
+        for (const T &x : c)
+          sum += sizeof(x) + *(const unsigned char *)&x;
+        bench_clobber(&sum);
+      }
+      bench_clobber(c.data());
+      bench_stop(&m);
+    }
+    bench_val_t vals[] = {bench_s("vector"), bench_s(container), bench_s(type),
+                          bench_s(ops[op]), bench_u(n), bench_u(reps * n)};
+    bench_row(vals, &m, reps * n);
+  }
+}
+
+template <typename T>
+static void run_both(const char *type)
+{
+  for (size_t n = 10; n <= 10000000; n *= 10)
+  {
+    if (!bench_fits(3 * n * sizeof(T)))
+      break;
+    run<prick::darr<T>>("prick::darr", type, n);
+    run<std::vector<T>>("std::vector", type, n);
+  }
+}
+
+int main()
+{
+  static const char *const cols[] = {"bench", "container", "type",
+                                     "op",    "n",         "ops"};
+  bench_begin(cols, sizeof(cols) / sizeof(cols[0]));
+  run_both<int>("int");
+  run_both<record>("record64");
+  run_both<std::string>("string");
+  return 0;
+}
@@ -14,16 +14,203 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define PRICK_DARR_HAS_FD
+#if defined(MAP_ANONYMOUS) || defined(MAP_ANON)
+#define PRICK_DARR_HAS_MMAP
+#endif
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+#define PRICK_DARR_HAS_MREMAP
+#endif
+// vmsplice is only declared with _GNU_SOURCE
+#ifdef __linux__
+#include <fcntl.h>
+#if defined(SPLICE_F_GIFT)
+#define PRICK_DARR_HAS_VMSPLICE
+#endif
+#endif
+#endif
+
+// Aligned allocation: aligned_alloc is C11 (and C++17), otherwise
+// POSIX's posix_memalign if libc declares it
+#if ((defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L) ||        \
+     (defined(__cplusplus) && __cplusplus >= 201703L)) &&                 \
+    !defined(_MSC_VER)
+#define PRICK_DARR_HAS_ALIGNED
+#elif (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200112L) ||         \
+    (defined(_XOPEN_SOURCE) && _XOPEN_SOURCE >= 600) || defined(__APPLE__)
+#define PRICK_DARR_HAS_ALIGNED
+#define __PRICK_DARR_POSIX_MEMALIGN
+#endif
+
+// Whether libc can tell us the real size of an allocation, used to
+// fill malloc's slack (define PRICK_DARR_NO_USABLE_SIZE to opt out)
+#ifndef PRICK_DARR_NO_USABLE_SIZE
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define PRICK_DARR_HAS_USABLE_SIZE
+#define __PRICK_DARR_USABLE_SIZE(PTR) malloc_usable_size(PTR)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define PRICK_DARR_HAS_USABLE_SIZE
+#define __PRICK_DARR_USABLE_SIZE(PTR) malloc_size(PTR)
+#endif
+#endif
+
+// Includes are kept out of the extern "C" block below, which mustn't
+// wrap standard headers in C++
+#if defined(PRICK_DARR_STATS) || defined(PRICK_DARR_PROFILE)
+#include <stdio.h>
+#endif
+
+#if defined(PRICK_DARR_IMPLEMENTATION) && defined(PRICK_DARR_HAS_FD)
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(PRICK_DARR_IMPLEMENTATION) && defined(PRICK_DARR_THREADS)
+#include <pthread.h>
+#endif
 
 #define PRICK_DARR_ALLOC_MULT   2
 #define PRICK_DARR_DEFAULT_SIZE 8
 
+// Size in bytes past which prick_darr_mremap_allocator uses mmap
+#define PRICK_DARR_MREMAP_THRESHOLD (64 * 1024 * 1024)
+
+// Least free space in bytes prick_darr_read_fd_all reads into at once
+#define PRICK_DARR_READ_CHUNK (64 * 1024)
+
+#define PRICK_DARR_FLAG_INLINE (1 << 0) // data is caller owned storage
+#define PRICK_DARR_FLAG_EXACT  (1 << 1) // don't round up to allocator slack
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Allocator used by a dynamic array for all of its memory.  Each
+ * function is given the context pointer stored in the dynamic array
+ * (prick_darr_t.allocator_ctx).  Sizes are in bytes; the old size of
+ * a block is passed back to realloc and free so allocators that don't
+ * track block sizes themselves (e.g. arenas) can still copy or
+ * release memory correctly.  If max_size is given, it returns the
+ * largest block in bytes the allocator can ever give, and capacity is
+ * never grown past it (NULL means no such limit).
+ */
+typedef struct
+{
+  void *(*alloc)(void *ctx, size_t size);
+  void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+  void (*free)(void *ctx, void *ptr, size_t size);
+  size_t (*max_size)(void *ctx);
+} prick_darr_allocator_t;
+
+typedef enum
+{
+  PRICK_DARR_GROWTH_MULT, // available * factor
+  PRICK_DARR_GROWTH_ADD,  // available + step
+  PRICK_DARR_GROWTH_FN,   // fn(used, requested, available)
+} prick_darr_growth_kind_t;
+
+/**
+ * Growth policy for a dynamic array i.e. how many members to allocate
+ * when prick_darr_ensure_capacity runs out of space.  Whatever the
+ * policy says, the new capacity is never less than what was
+ * requested.
+ */
+typedef struct
+{
+  prick_darr_growth_kind_t kind;
+  double factor; // for PRICK_DARR_GROWTH_MULT
+  size_t step;   // for PRICK_DARR_GROWTH_ADD
+  size_t (*fn)(size_t used, size_t requested, size_t available);
+} prick_darr_growth_t;
+
+#ifdef PRICK_DARR_STATS
+/**
+ * Allocation counters, kept per dynamic array and summed over all
+ * dynamic arrays when PRICK_DARR_STATS is defined.  Sizes are in
+ * bytes.  Global counters aren't synchronised, so they're only exact
+ * when dynamic arrays aren't changed by several threads at once.
+ */
+typedef struct
+{
+  size_t grows;           // number of times storage was grown
+  size_t shrinks;         // number of times storage was shrunk
+  size_t bytes_allocated; // total size of storage requested on growth
+  size_t bytes_copied;    // bytes copied to moved storage on growth
+  size_t peak_available;  // largest storage seen
+} prick_darr_stats_t;
+
+typedef struct
+{
+  prick_darr_stats_t total; // summed over every dynamic array
+  size_t used;              // bytes appended to live dynamic arrays
+  size_t available;         // bytes allocated by live dynamic arrays
+} prick_darr_global_stats_t;
+
+extern prick_darr_global_stats_t prick_darr_global_stats;
+
+#define __PRICK_DARR_STATS_USE(DARR, N) \
+  (prick_darr_global_stats.used += (N) * (DARR)->size)
+#define __PRICK_DARR_STATS_UNUSE(DARR, N) \
+  (prick_darr_global_stats.used -= (N) * (DARR)->size)
+#else
+#define __PRICK_DARR_STATS_USE(DARR, N)   ((void)0)
+#define __PRICK_DARR_STATS_UNUSE(DARR, N) ((void)0)
+#endif
+
+#ifdef PRICK_DARR_PROFILE
+// Maximum number of distinct call sites profiled
+#define PRICK_DARR_PROFILE_SITES 1024
+
+/**
+ * Profile of the dynamic arrays initialised at one call site, when
+ * PRICK_DARR_PROFILE is defined.  Sizes are in members.  With GCC or
+ * clang sites are safe to update from several threads at once (the
+ * table is locked and counters are atomic); otherwise profiling is
+ * only exact in single threaded programs.
+ */
+typedef struct
+{
+  const char *file; // NULL for sites known only by pc
+  int line;
+  const void *pc;  // return address, see PRICK_DARR_DEFINE
+  size_t arrays;   // arrays initialised here
+  size_t grows;    // growth events over all of those arrays
+  size_t freed;    // arrays freed, whose final size is known
+  size_t max_used; // high-water mark of used over all arrays
+  // Arrays freed, bucketed by final size: bucket 0 for empty, bucket
+  // b for sizes in (2^(b - 2), 2^(b - 1)]
+  size_t final_sizes[sizeof(size_t) * 8 + 1];
+} prick_darr_site_t;
+#endif
+
 typedef struct
 {
   size_t size;      // size of each "member"
   size_t used;      // number of elements currently used
   size_t available; // number of elements allocated
   uint8_t *data;
+  const prick_darr_allocator_t *allocator; // NULL means libc
+  void *allocator_ctx;
+  const prick_darr_growth_t *growth; // NULL means PRICK_DARR_ALLOC_MULT
+  unsigned int flags;
+#ifdef PRICK_DARR_STATS
+  prick_darr_stats_t stats;
+#endif
+#ifdef PRICK_DARR_PROFILE
+  prick_darr_site_t *site;
+#endif
 } prick_darr_t;
 
 /**
@@ -39,11 +226,11 @@ typedef struct
  *
  * @param N: Index of member
  */
-#define PRICK_DARR_AT(DARR, TYPE, N) (((TYPE *)(DARR).data)[N * (DARR).size])
+#define PRICK_DARR_AT(DARR, TYPE, N) (((TYPE *)(DARR).data)[(N)])
 
 /**
- * Initialises the dynamic array given with PRICK_DARR_DEFAULT_SIZE
- * number of elements.
+ * Initialises the dynamic array given with (at least)
+ * PRICK_DARR_DEFAULT_SIZE number of elements.
  *
  * @param prick_darr_t *: Dynamic array to initialise
  *
@@ -51,6 +238,284 @@ typedef struct
  */
 void prick_darr_init(prick_darr_t *, size_t);
 
+/**
+ * Initialises the dynamic array given with PRICK_DARR_DEFAULT_SIZE
+ * number of elements, using the allocator given for all memory the
+ * dynamic array will ever need.  If the allocator is NULL, libc's
+ * malloc/realloc/free are used.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param const prick_darr_allocator_t *: Allocator to use (can be
+ * NULL)
+ *
+ * @param void *: Context pointer given to the allocator
+ */
+void prick_darr_init_allocator(prick_darr_t *, size_t,
+                               const prick_darr_allocator_t *, void *);
+
+#ifdef PRICK_DARR_HAS_ALIGNED
+/**
+ * Allocator which keeps the storage of a dynamic array aligned, for
+ * SIMD loads or to keep arrays on separate cache lines.  The context
+ * pointer is the alignment in bytes (a power of two) cast to void *.
+ * Allocation sizes are rounded up to a multiple of the alignment.
+ * Growth always copies the members to a fresh aligned block, leaving
+ * the old block intact if that allocation fails.
+ */
+extern const prick_darr_allocator_t prick_darr_aligned_allocator;
+
+/**
+ * Initialises the dynamic array given with PRICK_DARR_DEFAULT_SIZE
+ * number of elements, whose storage is always aligned to the given
+ * alignment (including after prick_darr_ensure_capacity and
+ * prick_darr_tighten).  See prick_darr_aligned_allocator.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param size_t: Alignment in bytes (power of two)
+ */
+void prick_darr_init_aligned(prick_darr_t *, size_t, size_t);
+#endif
+
+#ifdef PRICK_DARR_HAS_MMAP
+/**
+ * Allocator which reserves a fixed range of virtual memory up front
+ * (without committing any of it) and commits pages as the dynamic
+ * array grows.  Storage never moves, so growth never copies members
+ * and pointers into the array stay valid.  The context pointer is the
+ * size of the reservation in bytes cast to void *; the growth policy
+ * is capped to it and growing beyond it fails, leaving the dynamic
+ * array as it was.  Shrinking decommits pages.
+ */
+extern const prick_darr_allocator_t prick_darr_vmem_allocator;
+
+/**
+ * Initialises the dynamic array given with PRICK_DARR_DEFAULT_SIZE
+ * number of elements, backed by a reservation of virtual memory big
+ * enough for the given number of members.  See
+ * prick_darr_vmem_allocator.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param size_t: Maximum number of members the array will ever hold
+ */
+void prick_darr_init_vmem(prick_darr_t *, size_t, size_t);
+
+/**
+ * Allocator which stores members in a file, mapped MAP_SHARED so the
+ * page cache does the paging and the members persist.  The context
+ * pointer is a file descriptor (open for reading and writing) cast to
+ * void *, which the caller keeps ownership of.  The first page of the
+ * file is a header recording the member size and number of members;
+ * members follow from the second page.  Growth extends the file
+ * (reserving its blocks with fallocate where supported, so a full
+ * disk fails the growth rather than a later write) and remaps it
+ * (with mremap on Linux), never copying members.  When growth fails,
+ * prick_darr_ensure_capacity returns -1 with errno left as the
+ * failing call set it (e.g. ENOSPC) and the members stay mapped.  Use
+ * with prick_darr_init_file rather than directly.
+ */
+extern const prick_darr_allocator_t prick_darr_file_allocator;
+
+/**
+ * Initialises the dynamic array given with its storage in a file (see
+ * prick_darr_file_allocator).  An empty file is set up for the member
+ * size given with PRICK_DARR_DEFAULT_SIZE number of elements; a file
+ * made by a previous dynamic array is mapped as is, with the members
+ * recorded by its last prick_darr_sync_file in use.  Freeing the
+ * dynamic array unmaps the file without truncating or closing it.
+ *
+ * Returns 0 on success, or -1 (with errno set, EINVAL if the file
+ * isn't one made for members of this size) on failure.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param int: File descriptor open for reading and writing
+ */
+int prick_darr_init_file(prick_darr_t *, size_t, int);
+
+/**
+ * Flushes members appended since the last sync to the file with
+ * msync, then records the number of used members in the header of the
+ * file (only after the members are on disk, so a crash never leaves a
+ * header counting members that weren't written).  Members changed in
+ * place must be flushed with prick_darr_sync_file_range first.  An
+ * array tightened to no members has no mapping, so its header is
+ * mapped just for the update.
+ *
+ * Returns 0 on success, or -1 (with errno set) on failure.
+ *
+ * @param prick_darr_t *: File backed dynamic array to sync
+ */
+int prick_darr_sync_file(prick_darr_t *);
+
+/**
+ * Flushes n members starting at a specific position in the file
+ * backed dynamic array to the file with msync.  Fails with EINVAL if
+ * position + number of elements is out of bounds i.e. more than
+ * number of used elements.
+ *
+ * Returns 0 on success, or -1 (with errno set) on failure.
+ *
+ * @param const prick_darr_t *: File backed dynamic array to sync
+ *
+ * @param size_t: Index of first member to sync
+ *
+ * @param size_t: Number of members to sync
+ */
+int prick_darr_sync_file_range(const prick_darr_t *, size_t, size_t);
+#endif
+
+#ifdef PRICK_DARR_HAS_MREMAP
+/**
+ * Allocator which uses malloc for small blocks, but page aligned mmap
+ * storage for blocks at or past a threshold, resized with mremap so
+ * the kernel moves page tables rather than the allocator copying
+ * bytes.  The context pointer is the threshold in bytes cast to void
+ * *, or NULL for PRICK_DARR_MREMAP_THRESHOLD.  Linux only, and needs
+ * _GNU_SOURCE defined before including system headers.
+ */
+extern const prick_darr_allocator_t prick_darr_mremap_allocator;
+
+/**
+ * Initialises the dynamic array given with PRICK_DARR_DEFAULT_SIZE
+ * number of elements, using prick_darr_mremap_allocator with the
+ * given threshold.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param size_t: Threshold in bytes (0 for
+ * PRICK_DARR_MREMAP_THRESHOLD)
+ */
+void prick_darr_init_mremap(prick_darr_t *, size_t, size_t);
+#endif
+
+/**
+ * Initialises the dynamic array given without allocating anything.
+ * The first call that needs space (prick_darr_append,
+ * prick_darr_append_n, prick_darr_ensure_capacity) allocates at least
+ * PRICK_DARR_DEFAULT_SIZE members.  Memory is never zeroed.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ */
+void prick_darr_init_lazy(prick_darr_t *, size_t);
+
+/**
+ * Initialises the dynamic array given to use the caller's buffer as
+ * its storage, making no allocations until the buffer overflows.  At
+ * that point members are moved to the heap and the buffer is never
+ * used again.  The buffer must outlive the dynamic array, and must
+ * not move while it is in use (so beware of copying a struct that
+ * holds both).  See PRICK_DARR_SMALL.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param void *: Buffer to use as initial storage
+ *
+ * @param size_t: Number of members the buffer can hold
+ */
+void prick_darr_init_inline(prick_darr_t *, size_t, void *, size_t);
+
+/**
+ * Initialises the dynamic array given to take ownership of an
+ * existing buffer of members without copying it.  The buffer must
+ * have been allocated by libc's malloc/realloc (or be NULL with no
+ * members available), and will be grown and freed like any other
+ * storage of the dynamic array.  Returns 0, or -1 if used is more than
+ * available (or the buffer is NULL but available isn't 0), in which
+ * case the dynamic array is initialised empty (see
+ * prick_darr_init_lazy) and the caller keeps the buffer.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param void *: Buffer to adopt
+ *
+ * @param size_t: Number of members in use in the buffer
+ *
+ * @param size_t: Number of members the buffer can hold
+ */
+int prick_darr_adopt(prick_darr_t *, size_t, void *, size_t, size_t);
+
+/**
+ * Initialises the dynamic array given to take ownership of an
+ * existing buffer allocated by the allocator given (with the same
+ * context).  See prick_darr_adopt and prick_darr_init_allocator.
+ *
+ * @param prick_darr_t *: Dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param void *: Buffer to adopt
+ *
+ * @param size_t: Number of members in use in the buffer
+ *
+ * @param size_t: Number of members the buffer can hold
+ *
+ * @param const prick_darr_allocator_t *: Allocator that made the buffer
+ * (NULL for libc)
+ *
+ * @param void *: Context pointer given to the allocator
+ */
+int prick_darr_adopt_allocator(prick_darr_t *, size_t, void *, size_t,
+                               size_t, const prick_darr_allocator_t *,
+                               void *);
+
+/**
+ * Type of a dynamic array bundled with inline storage for N members
+ * of TYPE.  Initialise with PRICK_DARR_SMALL_INIT and use the darr
+ * member with the rest of the API.
+ *
+ * @param TYPE: Type of members
+ *
+ * @param N: Number of members to store inline
+ */
+#define PRICK_DARR_SMALL(TYPE, N) \
+  struct                          \
+  {                               \
+    prick_darr_t darr;            \
+    TYPE buffer[N];               \
+  }
+
+/**
+ * Initialises a PRICK_DARR_SMALL (by pointer) to use its inline
+ * storage.
+ *
+ * @param SMALL: Pointer to a PRICK_DARR_SMALL
+ */
+#define PRICK_DARR_SMALL_INIT(SMALL)                                     \
+  prick_darr_init_inline(&(SMALL)->darr, sizeof(*(SMALL)->buffer),       \
+                         (SMALL)->buffer,                                \
+                         sizeof((SMALL)->buffer) / sizeof(*(SMALL)->buffer))
+
+/**
+ * Sets the growth policy of the dynamic array.  The policy is not
+ * copied so it must outlive the dynamic array; a static const policy
+ * shared between arrays is the expected usage.  If the policy is
+ * NULL, growth is by PRICK_DARR_ALLOC_MULT.
+ *
+ * @param prick_darr_t *: Dynamic array to set policy of
+ *
+ * @param const prick_darr_growth_t *: Growth policy (can be NULL)
+ */
+void prick_darr_set_growth(prick_darr_t *, const prick_darr_growth_t *);
+
 /**
  * Frees the memory associated with dynamic array, using the object
  * free function given to free each member of the dynamic array before
@@ -65,13 +530,17 @@ void prick_darr_free(prick_darr_t *, void (*)(void *));
 
 /**
  * Ensures there's enough capacity available for the size requested in
- * the given dynamic array.
+ * the given dynamic array.  With libc allocation, capacity may be
+ * rounded up further to use all the memory malloc actually gave (see
+ * PRICK_DARR_HAS_USABLE_SIZE and PRICK_DARR_FLAG_EXACT).  Returns 0,
+ * or -1 if the allocator failed, in which case the dynamic array is
+ * left as it was.
  *
  * @param prick_darr_t *: Dynamic array to check
  *
  * @param size_t: Number of members requested
  */
-void prick_darr_ensure_capacity(prick_darr_t *, size_t);
+int prick_darr_ensure_capacity(prick_darr_t *, size_t);
 
 /**
  * Attempts to shrink and tighten the container of the dynamic array
@@ -83,22 +552,52 @@ void prick_darr_ensure_capacity(prick_darr_t *, size_t);
  */
 void prick_darr_tighten(prick_darr_t *);
 
+/**
+ * Gives up ownership of the storage of the dynamic array without
+ * copying it, returning a pointer to its members and leaving the
+ * dynamic array empty (with no storage, but the same allocator and
+ * growth policy) for reuse.  The caller must free the storage with
+ * the allocator of the dynamic array (libc's free if it has none),
+ * giving it the size of the storage, i.e. the number of members
+ * available times the member size.  Tightening first makes that the
+ * same as the number of members in use, which is useful when the
+ * receiver only knows the latter.  Inline storage can't be given
+ * away, so it is copied to a new allocation first.  Returns NULL if
+ * there are no members and the dynamic array was tightened, or if
+ * there are members but the storage couldn't be copied out of inline
+ * storage or tightened as asked, in which case the dynamic array is
+ * left as it was.
+ *
+ * @param prick_darr_t *: Dynamic array to release
+ *
+ * @param size_t *: Set to the number of members in use (can be NULL)
+ *
+ * @param size_t *: Set to the number of members the storage can hold
+ * (can be NULL)
+ *
+ * @param int: Whether to tighten (see prick_darr_tighten) first
+ */
+void *prick_darr_release(prick_darr_t *, size_t *, size_t *, int);
+
 /**
  * Appends the element (at pointer) to the dynamic array.  Assumes
  * element is of the same type as the members of the dynamic array
- * (hence has the same size in bytes as prick_darr_t.size).
+ * (hence has the same size in bytes as prick_darr_t.size).  Returns
+ * 0, or -1 if the dynamic array couldn't grow (see
+ * prick_darr_ensure_capacity), in which case nothing is appended.
  *
  * @param prick_darr_t *: Dynamic array to append to
  *
  * @param void *: (Pointer to) element to append
  */
-void prick_darr_append(prick_darr_t *, void *);
+int prick_darr_append(prick_darr_t *, void *);
 
 /**
  * Appends array of n elements (referred by pointer) to the dynamic
  * array.  Assumes each element is of the same type as the members of
  * the dynamic array (hence has the same size in bytes as
- * prick_darr_t.size).
+ * prick_darr_t.size).  Returns 0, or -1 if the dynamic array couldn't
+ * grow, in which case nothing is appended.
  *
  * @param prick_darr_t *: Dynamic array to append to
  *
@@ -106,7 +605,7 @@ void prick_darr_append(prick_darr_t *, void *);
  *
  * @param size_t: Number of elements in array to append
  */
-void prick_darr_append_n(prick_darr_t *, void *, size_t);
+int prick_darr_append_n(prick_darr_t *, void *, size_t);
 
 /**
  * Writes the element (at pointer) at a specific position in the
@@ -141,64 +640,1809 @@ void prick_darr_write(prick_darr_t *, void *, size_t);
  */
 void prick_darr_write_n(prick_darr_t *, void *, size_t, size_t);
 
-#ifndef PRICK_DARR_IMPLEMENTATION
-#define PRICK_DARR_IMPLEMENTATION
-
-#include <string.h>
+/**
+ * Inserts array of n elements (referred by pointer) at a specific
+ * position in the dynamic array, shifting members from that position
+ * onwards up by n.  Ensures capacity once and moves the tail with a
+ * single memmove.  Will stop if position is out of bounds i.e. more
+ * than number of used elements (inserting at used appends).  Returns
+ * 0, or -1 if nothing was inserted because the position was out of
+ * bounds or the dynamic array couldn't grow.
+ *
+ * @param prick_darr_t *: Dynamic array to insert in
+ *
+ * @param void *: (Pointer to) array of elements to insert
+ *
+ * @param size_t: Number of elements in array to insert
+ *
+ * @param size_t: Index where to insert elements
+ */
+int prick_darr_insert_n(prick_darr_t *, void *, size_t, size_t);
 
-#define __PRICK_DARR_MAX(a, b) ((a) > (b) ? (a) : (b))
+/**
+ * Inserts n elements (referred by pointer) at n positions in the
+ * dynamic array in one pass: element i is inserted before the member
+ * at index indices[i] of the array as it was before the call.
+ * Indices must be sorted in ascending order (repeats are inserted in
+ * order) and none may be more than the number of used elements,
+ * otherwise nothing is inserted.  Every existing member is moved at
+ * most once.  Returns 0, or -1 if nothing was inserted because of bad
+ * indices or the dynamic array couldn't grow.
+ *
+ * @param prick_darr_t *: Dynamic array to insert in
+ *
+ * @param void *: (Pointer to) array of elements to insert
+ *
+ * @param size_t: Number of elements in array to insert
+ *
+ * @param const size_t *: Sorted array of n indices to insert at
+ */
+int prick_darr_insert_many(prick_darr_t *, void *, size_t, const size_t *);
 
-void prick_darr_init(prick_darr_t *darr, size_t member_size)
-{
-  if (!darr)
-    return;
-  *darr = (prick_darr_t){
-      .size      = member_size,
-      .used      = 0,
-      .available = PRICK_DARR_DEFAULT_SIZE,
-      .data      = NULL,
-  };
-  darr->data = calloc(1, member_size * PRICK_DARR_DEFAULT_SIZE);
-}
+/**
+ * Removes n members starting at a specific position in the dynamic
+ * array, shifting the members after them down with a single memmove.
+ * Will stop if position + number of elements is out of bounds
+ * i.e. more than number of used elements.
+ *
+ * @param prick_darr_t *: Dynamic array to erase from
+ *
+ * @param size_t: Index of first member to erase
+ *
+ * @param size_t: Number of members to erase
+ */
+void prick_darr_erase_range(prick_darr_t *, size_t, size_t);
 
-void prick_darr_free(prick_darr_t *darr, void (*mem_free)(void *))
-{
-  if (mem_free)
-    for (size_t i = 0; i < darr->used; ++i)
-      mem_free(darr->data + (i * darr->size));
-  free(darr->data);
-}
+/**
+ * Removes the last member of the dynamic array, copying it into out
+ * first (unless out is NULL).  Returns 0, or -1 if the dynamic array
+ * is empty, in which case out is left untouched.
+ *
+ * @param prick_darr_t *: Dynamic array to pop from
+ *
+ * @param void *: (Pointer to) where to copy the member (can be NULL)
+ */
+int prick_darr_pop(prick_darr_t *, void *);
 
-void prick_darr_ensure_capacity(prick_darr_t *darr, size_t requested)
-{
-  for (; darr->used + requested > darr->available;
-       darr->available = __PRICK_DARR_MAX(
-           darr->available * PRICK_DARR_ALLOC_MULT, darr->used + requested),
-       darr->data = realloc(darr->data, darr->available * darr->size))
-    continue;
-}
+/**
+ * Removes the member at a specific position in the dynamic array in
+ * O(1) by moving the last member into its place, so the order of
+ * members isn't kept.  Will stop if position is out of bounds
+ * i.e. not less than number of used elements.
+ *
+ * @param prick_darr_t *: Dynamic array to remove from
+ *
+ * @param size_t: Index of member to remove
+ */
+void prick_darr_swap_remove(prick_darr_t *, size_t);
 
-void prick_darr_tighten(prick_darr_t *darr)
-{
-  if (darr->used < darr->available)
-  {
-    darr->data = realloc(darr->data, darr->used * darr->size);
-    darr->used = darr->available;
-  }
-}
+/**
+ * Removes n members at n positions in the dynamic array, each with
+ * prick_darr_swap_remove, working from the highest index down so
+ * members moved into a hole are never ones still to be removed.
+ * Indices must be strictly ascending and all less than the number of
+ * used elements, otherwise nothing is removed.
+ *
+ * @param prick_darr_t *: Dynamic array to remove from
+ *
+ * @param size_t: Number of members to remove
+ *
+ * @param const size_t *: Sorted array of n indices to remove
+ */
+void prick_darr_swap_remove_many(prick_darr_t *, size_t, const size_t *);
 
-void prick_darr_append(prick_darr_t *darr, void *ptr)
-{
-  prick_darr_ensure_capacity(darr, 1);
-  memcpy(darr->data + (darr->used * darr->size), ptr, darr->size);
-  ++darr->used;
-}
+#ifdef PRICK_DARR_HAS_FD
+/**
+ * Reads up to max_bytes (rounded up to a whole member) from the file
+ * descriptor straight into the end of the dynamic array, with no
+ * intermediate buffer.  Capacity is ensured beforehand with
+ * prick_darr_ensure_capacity.  Like read(2) fewer bytes may be read
+ * than asked for, but a member is never left half read: after a short
+ * read in the middle of a member, reading carries on (waiting for the
+ * descriptor with poll(2) if it's non-blocking) until the member is
+ * complete.  Only EOF or an error can cut a member short, in which
+ * case its bytes are left in the storage just past the used members.
+ *
+ * Returns the number of bytes read (0 at EOF) of which
+ * bytes / prick_darr_t.size members were appended, or -1 (with errno
+ * set) if nothing could be read because of an error, including the
+ * dynamic array failing to grow (ENOMEM unless the allocator set
+ * errno).
+ *
+ * @param prick_darr_t *: Dynamic array to read into
+ *
+ * @param int: File descriptor to read from
+ *
+ * @param size_t: Maximum number of bytes to read
+ */
+ssize_t prick_darr_read_fd(prick_darr_t *, int, size_t);
 
-void prick_darr_append_n(prick_darr_t *darr, void *ptr, size_t n)
-{
-  prick_darr_ensure_capacity(darr, n);
+/**
+ * Reads from the file descriptor until EOF, appending everything read
+ * to the dynamic array.  For regular files capacity for the rest of
+ * the file is ensured up front; otherwise reads are made into at
+ * least PRICK_DARR_READ_CHUNK bytes of free space, growing by the
+ * growth policy of the dynamic array.  See prick_darr_read_fd.
+ *
+ * Returns the total number of bytes read, or -1 (with errno set) on
+ * an error, in which case members read before the error are kept.
+ *
+ * @param prick_darr_t *: Dynamic array to read into
+ *
+ * @param int: File descriptor to read from
+ */
+ssize_t prick_darr_read_fd_all(prick_darr_t *, int);
+
+/**
+ * Writes n members starting at a specific position in the dynamic
+ * array to the file descriptor, resuming partial writes (and waiting
+ * for the descriptor with poll(2) if it's non-blocking) until all of
+ * them are written.  Will stop if position + number of elements is
+ * out of bounds i.e. more than number of used elements.
+ *
+ * Returns the number of bytes written, which is less than asked for
+ * only if an error stopped the write (errno is set), or -1 if the
+ * error came before anything was written.
+ *
+ * @param const prick_darr_t *: Dynamic array to write from
+ *
+ * @param int: File descriptor to write to
+ *
+ * @param size_t: Index of first member to write
+ *
+ * @param size_t: Number of members to write
+ */
+ssize_t prick_darr_write_fd(const prick_darr_t *, int, size_t, size_t);
+
+/**
+ * Writes all used members of n dynamic arrays, one after the other,
+ * to the file descriptor with as few writev(2) calls as possible
+ * (usually one), resuming partial writes.  Returns as
+ * prick_darr_write_fd.
+ *
+ * @param const prick_darr_t *: Array of n dynamic arrays to write
+ *
+ * @param size_t: Number of dynamic arrays
+ *
+ * @param int: File descriptor to write to
+ */
+ssize_t prick_darr_write_fd_many(const prick_darr_t *, size_t, int);
+
+#ifdef PRICK_DARR_HAS_VMSPLICE
+/**
+ * Like prick_darr_write_fd, but for a pipe on Linux: the pages holding
+ * the members are handed to the pipe with vmsplice(2) rather than
+ * copied into it.  The pipe only references the storage, so the
+ * members must not be changed, nor the dynamic array grown, tightened
+ * or freed, until the reader has consumed everything written.  If the
+ * descriptor isn't a pipe vmsplice fails (errno EBADF or EINVAL).
+ *
+ * @param const prick_darr_t *: Dynamic array to write from
+ *
+ * @param int: Pipe to write to
+ *
+ * @param size_t: Index of first member to write
+ *
+ * @param size_t: Number of members to write
+ */
+ssize_t prick_darr_vmsplice_fd(const prick_darr_t *, int, size_t, size_t);
+#endif
+#endif
+
+#ifdef PRICK_DARR_STATS
+/**
+ * Prints the allocation counters of a dynamic array as one line of
+ * space separated key=value pairs, including its current slack
+ * (available - used, in bytes).  If the dynamic array is NULL, prints
+ * the global counters summed over every dynamic array instead.
+ *
+ * @param FILE *: Stream to print to
+ *
+ * @param const prick_darr_t *: Dynamic array to print counters of
+ * (can be NULL)
+ */
+void prick_darr_stats_dump(FILE *, const prick_darr_t *);
+#endif
+
+#ifdef PRICK_DARR_PROFILE
+/**
+ * Prints one line per profiled call site: where it is, how many
+ * arrays it made, how often they grew, their high-water mark and a
+ * recommended initial capacity (the power of two that would have
+ * covered the final size of 90% of the arrays freed).  Sites known
+ * only by return address (see PRICK_DARR_DEFINE) are printed as pc=,
+ * for addr2line -i (less the load address of a position independent
+ * executable).
+ *
+ * @param FILE *: Stream to print to
+ */
+void prick_darr_profile_dump(FILE *);
+
+/**
+ * Attributes the dynamic array to the call site given if it has none
+ * yet.  Used by prick::darr, whose constructors are given the
+ * location of their caller.
+ */
+void __prick_darr_claim(prick_darr_t *, const char *, int);
+
+#if defined(__GNUC__) || defined(__clang__)
+/**
+ * Attributes the dynamic array to wherever this is called from (by
+ * return address, dumped as pc=) if it has none yet.  Used by the
+ * functions PRICK_DARR_DEFINE makes, which are then always inlined
+ * so the return address is in their caller.
+ */
+void __prick_darr_claim_caller(prick_darr_t *);
+#endif
+
+/**
+ * The entry points which make or grow a dynamic array, attributing it
+ * to the call site given: init variants always do, the rest only if
+ * it has no site yet (e.g. when adopted by a variant which isn't
+ * profiled).  Used through macros of the same names as the entry
+ * points, defined when PRICK_DARR_PROFILE is.
+ */
+void __prick_darr_init_site(prick_darr_t *, size_t, const char *, int);
+void __prick_darr_init_allocator_site(prick_darr_t *, size_t,
+                                      const prick_darr_allocator_t *, void *,
+                                      const char *, int);
+#ifdef PRICK_DARR_HAS_ALIGNED
+void __prick_darr_init_aligned_site(prick_darr_t *, size_t, size_t,
+                                    const char *, int);
+#endif
+#ifdef PRICK_DARR_HAS_MMAP
+void __prick_darr_init_vmem_site(prick_darr_t *, size_t, size_t, const char *,
+                                 int);
+int __prick_darr_init_file_site(prick_darr_t *, size_t, int, const char *,
+                                int);
+#endif
+#ifdef PRICK_DARR_HAS_MREMAP
+void __prick_darr_init_mremap_site(prick_darr_t *, size_t, size_t,
+                                   const char *, int);
+#endif
+void __prick_darr_init_lazy_site(prick_darr_t *, size_t, const char *, int);
+void __prick_darr_init_inline_site(prick_darr_t *, size_t, void *, size_t,
+                                   const char *, int);
+int __prick_darr_adopt_site(prick_darr_t *, size_t, void *, size_t, size_t,
+                            const char *, int);
+int __prick_darr_adopt_allocator_site(prick_darr_t *, size_t, void *, size_t,
+                                      size_t, const prick_darr_allocator_t *,
+                                      void *, const char *, int);
+int __prick_darr_ensure_capacity_site(prick_darr_t *, size_t, const char *,
+                                      int);
+int __prick_darr_append_site(prick_darr_t *, void *, const char *, int);
+int __prick_darr_append_n_site(prick_darr_t *, void *, size_t, const char *,
+                               int);
+int __prick_darr_insert_n_site(prick_darr_t *, void *, size_t, size_t,
+                               const char *, int);
+int __prick_darr_insert_many_site(prick_darr_t *, void *, size_t,
+                                  const size_t *, const char *, int);
+#endif
+
+// Storage class of, and profiling of call sites by, the functions
+// PRICK_DARR_DEFINE makes which may make or grow a dynamic array
+#if defined(PRICK_DARR_PROFILE) && (defined(__GNUC__) || defined(__clang__))
+#define __PRICK_DARR_DEFINE_FN \
+  static inline __attribute__((always_inline))
+#define __PRICK_DARR_DEFINE_SITE(DARR) __prick_darr_claim_caller(DARR)
+#elif defined(PRICK_DARR_PROFILE)
+#define __PRICK_DARR_DEFINE_FN static inline
+#define __PRICK_DARR_DEFINE_SITE(DARR) \
+  __prick_darr_claim((DARR), __FILE__, __LINE__)
+#else
+#define __PRICK_DARR_DEFINE_FN         static inline
+#define __PRICK_DARR_DEFINE_SITE(DARR) ((void)0)
+#endif
+
+/**
+ * Defines NAME_t, a dynamic array of TYPE, along with static inline
+ * functions over it where the member size is known at compile time:
+ *
+ * - NAME_init(NAME_t *), NAME_free(NAME_t *)
+ * - NAME_of(prick_darr_t *): view an existing dynamic array as NAME_t
+ * - NAME_reserve(NAME_t *, size_t): see prick_darr_ensure_capacity
+ * - NAME_push(NAME_t *, TYPE), NAME_push_n(NAME_t *, const TYPE *,
+ *   size_t)
+ * - NAME_at(NAME_t *, size_t): pointer to a member, unchecked
+ * - NAME_len(const NAME_t *), NAME_data(NAME_t *)
+ *
+ * NAME_t.darr is a regular prick_darr_t, so the rest of the API can
+ * be used on it directly.  Growth goes through
+ * prick_darr_ensure_capacity, so allocators and growth policies are
+ * respected, and NAME_reserve, NAME_push and NAME_push_n return its
+ * result.  With PRICK_DARR_PROFILE, arrays are attributed to the
+ * callers of these functions rather than to this macro (by return
+ * address with GCC and Clang, which always inline them).
+ *
+ * @param TYPE: Type of members
+ *
+ * @param NAME: Prefix for the type and functions defined
+ */
+#define PRICK_DARR_DEFINE(TYPE, NAME)                                      \
+  typedef struct                                                           \
+  {                                                                        \
+    prick_darr_t darr;                                                     \
+  } NAME##_t;                                                              \
+                                                                           \
+  __PRICK_DARR_DEFINE_FN void NAME##_init(NAME##_t *arr)                   \
+  {                                                                        \
+    (prick_darr_init)(&arr->darr, sizeof(TYPE));                           \
+    __PRICK_DARR_DEFINE_SITE(&arr->darr);                                  \
+  }                                                                        \
+                                                                           \
+  static inline void NAME##_free(NAME##_t *arr)                            \
+  {                                                                        \
+    prick_darr_free(&arr->darr, NULL);                                     \
+  }                                                                        \
+                                                                           \
+  static inline NAME##_t *NAME##_of(prick_darr_t *darr)                    \
+  {                                                                        \
+    return (NAME##_t *)darr;                                               \
+  }                                                                        \
+                                                                           \
+  __PRICK_DARR_DEFINE_FN int NAME##_reserve(NAME##_t *arr, size_t n)       \
+  {                                                                        \
+    __PRICK_DARR_DEFINE_SITE(&arr->darr);                                  \
+    return (prick_darr_ensure_capacity)(&arr->darr, n);                    \
+  }                                                                        \
+                                                                           \
+  __PRICK_DARR_DEFINE_FN int NAME##_push(NAME##_t *arr, TYPE value)        \
+  {                                                                        \
+    if (arr->darr.used == arr->darr.available &&                           \
+        (__PRICK_DARR_DEFINE_SITE(&arr->darr),                             \
+         (prick_darr_ensure_capacity)(&arr->darr, 1)))                     \
+      return -1;                                                           \
+    ((TYPE *)arr->darr.data)[arr->darr.used++] = value;                    \
+    __PRICK_DARR_STATS_USE(&arr->darr, 1);                                 \
+    return 0;                                                              \
+  }                                                                        \
+                                                                           \
+  __PRICK_DARR_DEFINE_FN int NAME##_push_n(NAME##_t *arr,                  \
+                                           const TYPE *values, size_t n)   \
+  {                                                                        \
+    if (n == 0)                                                            \
+      return 0;                                                            \
+    __PRICK_DARR_DEFINE_SITE(&arr->darr);                                  \
+    if ((prick_darr_ensure_capacity)(&arr->darr, n))                       \
+      return -1;                                                           \
+    memcpy((TYPE *)arr->darr.data + arr->darr.used, values,                \
+           n * sizeof(TYPE));                                              \
+    arr->darr.used += n;                                                   \
+    __PRICK_DARR_STATS_USE(&arr->darr, n);                                 \
+    return 0;                                                              \
+  }                                                                        \
+                                                                           \
+  static inline TYPE *NAME##_at(NAME##_t *arr, size_t n)                   \
+  {                                                                        \
+    return (TYPE *)arr->darr.data + n;                                     \
+  }                                                                        \
+                                                                           \
+  static inline size_t NAME##_len(const NAME##_t *arr)                     \
+  {                                                                        \
+    return arr->darr.used;                                                 \
+  }                                                                        \
+                                                                           \
+  static inline TYPE *NAME##_data(NAME##_t *arr)                           \
+  {                                                                        \
+    return (TYPE *)arr->darr.data;                                         \
+  }
+
+// Number of members prick_darr_inc_append migrates per call
+#define PRICK_DARR_INC_STEP 64
+
+/**
+ * A dynamic array which grows incrementally: rather than the append
+ * that triggers growth copying every member, growth only allocates
+ * the new storage and each later append migrates a bounded number
+ * (PRICK_DARR_INC_STEP) of members from the old storage.  While
+ * migrating, members must be read through prick_darr_inc_at; once
+ * prick_darr_inc_finish has been called, darr is a regular dynamic
+ * array.
+ */
+typedef struct
+{
+  prick_darr_t darr;    // members [migrated, old_used) not here yet
+  uint8_t *old;         // previous storage while migrating, else NULL
+  size_t old_available; // members allocated in old
+  size_t old_used;      // members to migrate from old
+  size_t migrated;      // members migrated from old so far
+  int old_inline;       // whether old is caller owned storage
+} prick_darr_inc_t;
+
+/**
+ * Initialises the incremental dynamic array given with
+ * PRICK_DARR_DEFAULT_SIZE number of elements.
+ *
+ * @param prick_darr_inc_t *: Incremental dynamic array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ */
+void prick_darr_inc_init(prick_darr_inc_t *, size_t);
+
+/**
+ * Frees the memory associated with the incremental dynamic array.
+ * See prick_darr_free.
+ *
+ * @param prick_darr_inc_t *: Incremental dynamic array to free
+ *
+ * @param void (*)(void *): Member freeing function (can be NULL)
+ */
+void prick_darr_inc_free(prick_darr_inc_t *, void (*)(void *));
+
+/**
+ * Appends the element (at pointer) to the incremental dynamic array,
+ * migrating up to PRICK_DARR_INC_STEP members if a migration is in
+ * progress.  Growth (when needed) allocates new storage but copies
+ * nothing.  Returns 0, or -1 if the allocator failed, in which case
+ * nothing is appended.
+ *
+ * @param prick_darr_inc_t *: Incremental dynamic array to append to
+ *
+ * @param void *: (Pointer to) element to append
+ */
+int prick_darr_inc_append(prick_darr_inc_t *, void *);
+
+/**
+ * Gets a pointer to the Nth member of the incremental dynamic array,
+ * wherever it currently lives.  Does no bounds checking.
+ *
+ * @param prick_darr_inc_t *: Incremental dynamic array to index
+ *
+ * @param size_t: Index of member
+ */
+void *prick_darr_inc_at(prick_darr_inc_t *, size_t);
+
+/**
+ * Completes any migration in progress, after which all members are in
+ * prick_darr_inc_t.darr.data.
+ *
+ * @param prick_darr_inc_t *: Incremental dynamic array to finish
+ */
+void prick_darr_inc_finish(prick_darr_inc_t *);
+
+/**
+ * Initialises n dynamic arrays (without allocating) to be used as
+ * private per-thread staging buffers, later merged into one dynamic
+ * array with prick_darr_merge.
+ *
+ * @param prick_darr_t *: Array of n dynamic arrays to initialise
+ *
+ * @param size_t: Number of staging arrays
+ *
+ * @param size_t: Size of member type in bytes
+ */
+void prick_darr_init_stages(prick_darr_t *, size_t, size_t);
+
+/**
+ * First step of merging staging arrays into a target: computes the
+ * offset of each staging array in the target with a prefix sum,
+ * ensures capacity in the target once for all of them and marks the
+ * space as used.  Members can then be copied over independently (and
+ * concurrently) with prick_darr_merge_copy.
+ *
+ * @param prick_darr_t *: Dynamic array to merge into
+ *
+ * @param const prick_darr_t *: Array of n staging arrays
+ *
+ * @param size_t: Number of staging arrays
+ *
+ * @param size_t *: Array of n offsets, filled with the index in the
+ * target each staging array should be copied to
+ *
+ * Returns 0, or -1 if the target couldn't grow, in which case it's
+ * left as it was.
+ */
+int prick_darr_merge_prepare(prick_darr_t *, const prick_darr_t *, size_t,
+                             size_t *);
+
+/**
+ * Copies all members of a staging array to the target at the offset
+ * given by prick_darr_merge_prepare, then empties the staging array
+ * (keeping its capacity for reuse).  Copies of different staging
+ * arrays into the same target may run concurrently.
+ *
+ * @param prick_darr_t *: Dynamic array to merge into
+ *
+ * @param prick_darr_t *: Staging array to copy from
+ *
+ * @param size_t: Offset in the target to copy to
+ */
+void prick_darr_merge_copy(prick_darr_t *, prick_darr_t *, size_t);
+
+/**
+ * Appends all members of n staging arrays to the target, in order of
+ * staging array, emptying each staging array.  Capacity is ensured
+ * once for the lot.  If PRICK_DARR_THREADS is defined, the staging
+ * arrays are copied in parallel with POSIX threads; otherwise they're
+ * copied one by one (use prick_darr_merge_prepare and
+ * prick_darr_merge_copy to parallelise with your own threads).
+ * Returns 0, or -1 if memory ran out, in which case nothing is merged.
+ *
+ * @param prick_darr_t *: Dynamic array to merge into
+ *
+ * @param prick_darr_t *: Array of n staging arrays
+ *
+ * @param size_t: Number of staging arrays
+ */
+int prick_darr_merge(prick_darr_t *, prick_darr_t *, size_t);
+
+/**
+ * Fat pointer dynamic arrays: the prick_darr_t describing the array
+ * lives in the same allocation as its members, immediately before
+ * them, and the user holds a plain pointer to the first member (NULL
+ * being an empty array).  Indexing is then just P[i], without first
+ * loading the data pointer out of a prick_darr_t.  Functions that
+ * may grow the array return the (possibly moved) pointer, which the
+ * macros below assign back to P, so any other copies of P are stale
+ * after growth.
+ *
+ * The header is a regular prick_darr_t, so allocators, growth policies
+ * and PRICK_DARR_STATS all apply to it, and it may be read (e.g. with
+ * prick_darr_stats_dump), but it must not be passed to any function
+ * which changes the storage of a prick_darr_t.
+ */
+
+// Alignment of the first member of a fat pointer dynamic array
+#define PRICK_DARR_FAT_ALIGN 16
+// Bytes from the start of the allocation to the first member
+#define PRICK_DARR_FAT_OFFSET                                              \
+  ((sizeof(prick_darr_t) + PRICK_DARR_FAT_ALIGN - 1) /                     \
+   PRICK_DARR_FAT_ALIGN * PRICK_DARR_FAT_ALIGN)
+
+#ifdef __cplusplus
+#define __PRICK_DARR_FAT_CAST(P) (decltype(P))
+#else
+#define __PRICK_DARR_FAT_CAST(P)
+#endif
+
+/**
+ * UNSAFE!
+ *
+ * Gets the header of the fat pointer dynamic array P, which must not
+ * be NULL.
+ */
+#define PRICK_DARR_FAT(P)                                                  \
+  ((prick_darr_t *)((uint8_t *)(P) - PRICK_DARR_FAT_OFFSET))
+
+#define PRICK_DARR_FAT_LEN(P) ((P) ? PRICK_DARR_FAT(P)->used : 0)
+#define PRICK_DARR_FAT_CAP(P) ((P) ? PRICK_DARR_FAT(P)->available : 0)
+
+/**
+ * Ensures P has capacity for N more members, only calling into the
+ * library when it has to grow.  Evaluates to 1, or 0 if P couldn't
+ * grow (in which case it's left as it was).
+ */
+#define PRICK_DARR_FAT_RESERVE(P, N)                                       \
+  ((P) && PRICK_DARR_FAT(P)->used + (N) <= PRICK_DARR_FAT(P)->available   \
+       ? 1                                                                 \
+       : ((P) = __PRICK_DARR_FAT_CAST(P)                                   \
+              prick_darr_fat_grow((P), sizeof(*(P)), (N)),                 \
+          (P) && PRICK_DARR_FAT(P)->used + (N) <=                          \
+                     PRICK_DARR_FAT(P)->available))
+
+// Appends X to P, evaluating to 1, or 0 if P couldn't grow
+#define PRICK_DARR_FAT_PUSH(P, X)                                          \
+  (PRICK_DARR_FAT_RESERVE(P, 1)                                            \
+       ? (__PRICK_DARR_STATS_USE(PRICK_DARR_FAT(P), 1),                    \
+          (P)[PRICK_DARR_FAT(P)->used++] = (X), 1)                         \
+       : 0)
+
+// Appends array of N members at SRC to P, evaluating to 1, or 0 if P
+// couldn't grow
+#define PRICK_DARR_FAT_APPEND_N(P, SRC, N)                                 \
+  ((N) == 0 || PRICK_DARR_FAT_RESERVE(P, N)                                \
+       ? ((P) = __PRICK_DARR_FAT_CAST(P)                                   \
+              prick_darr_fat_append_n((P), sizeof(*(P)), (SRC), (N)),      \
+          1)                                                               \
+       : 0)
+
+/**
+ * UNSAFE!
+ *
+ * Removes and evaluates to the last member of P, which must not be
+ * empty.
+ */
+#define PRICK_DARR_FAT_POP(P)                                              \
+  (__PRICK_DARR_STATS_UNUSE(PRICK_DARR_FAT(P), 1),                         \
+   (P)[--PRICK_DARR_FAT(P)->used])
+
+// Frees P (members aren't freed) and sets it to NULL
+#define PRICK_DARR_FAT_FREE(P) (prick_darr_fat_free((P)), (P) = NULL)
+
+/**
+ * Makes a fat pointer dynamic array with capacity for n members,
+ * returning the pointer to its first member.  Returns NULL if
+ * allocation fails.
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param size_t: Number of members to allocate
+ */
+void *prick_darr_fat_init(size_t, size_t);
+
+/**
+ * Makes a fat pointer dynamic array with capacity for n members,
+ * allocating (and later growing and freeing) it with the given
+ * allocator.  See prick_darr_fat_init and prick_darr_init_allocator.
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param size_t: Number of members to allocate
+ *
+ * @param const prick_darr_allocator_t *: Allocator to use (NULL for
+ * libc)
+ *
+ * @param void *: Context passed to every call of the allocator
+ */
+void *prick_darr_fat_init_allocator(size_t, size_t,
+                                    const prick_darr_allocator_t *, void *);
+
+/**
+ * Ensures the fat pointer dynamic array has capacity for the number
+ * of members requested, following its growth policy, and returns the
+ * (possibly moved) pointer to its first member.  If the pointer is
+ * NULL, makes a new array.  If the allocator fails, the array is left
+ * as it was and the pointer given is returned, so callers must check
+ * the capacity (see PRICK_DARR_FAT_RESERVE).
+ *
+ * @param void *: Fat pointer dynamic array to grow (can be NULL)
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param size_t: Number of members requested
+ */
+void *prick_darr_fat_grow(void *, size_t, size_t);
+
+/**
+ * Appends array of n elements (referred by pointer) to the fat pointer
+ * dynamic array, returning the (possibly moved) pointer to its first
+ * member.  Nothing is appended if the array couldn't grow (see
+ * prick_darr_fat_grow).
+ *
+ * @param void *: Fat pointer dynamic array to append to (can be NULL)
+ *
+ * @param size_t: Size of member type in bytes
+ *
+ * @param const void *: (Pointer to) array of elements to append
+ *
+ * @param size_t: Number of elements in array to append
+ */
+void *prick_darr_fat_append_n(void *, size_t, const void *, size_t);
+
+/**
+ * Frees the memory associated with the fat pointer dynamic array.
+ * Does nothing if the pointer is NULL.
+ *
+ * @param void *: Fat pointer dynamic array to free
+ */
+void prick_darr_fat_free(void *);
+
+// Define PRICK_DARR_IMPLEMENTATION in exactly one source file
+#ifdef PRICK_DARR_IMPLEMENTATION
+
+#define __PRICK_DARR_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define __PRICK_DARR_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#ifdef PRICK_DARR_STATS
+prick_darr_global_stats_t prick_darr_global_stats;
+
+// Records storage of a dynamic array changing size (from 0 when
+// allocated, to 0 when freed), copying the given number of bytes if it
+// moved
+static void __prick_darr_stats_resize(prick_darr_t *darr, size_t old_size,
+                                      size_t new_size, size_t copied)
+{
+  prick_darr_stats_t *stats[] = {&darr->stats, &prick_darr_global_stats.total};
+  for (size_t i = 0; i < 2; ++i)
+  {
+    if (new_size > old_size)
+    {
+      ++stats[i]->grows;
+      stats[i]->bytes_allocated += new_size;
+      stats[i]->bytes_copied += copied;
+    }
+    else if (new_size < old_size && new_size > 0)
+      ++stats[i]->shrinks;
+    stats[i]->peak_available = __PRICK_DARR_MAX(stats[i]->peak_available,
+                                                new_size);
+  }
+  prick_darr_global_stats.available += new_size - old_size;
+}
+
+#define __PRICK_DARR_STATS_RESIZE(DARR, OLD, NEW, COPIED) \
+  __prick_darr_stats_resize((DARR), (OLD), (NEW), (COPIED))
+
+void prick_darr_stats_dump(FILE *fp, const prick_darr_t *darr)
+{
+  const prick_darr_stats_t *stats =
+      darr ? &darr->stats : &prick_darr_global_stats.total;
+  size_t slack = darr ? (darr->available - darr->used) * darr->size
+                      : prick_darr_global_stats.available -
+                            prick_darr_global_stats.used;
+  fprintf(fp,
+          "grows=%zu shrinks=%zu bytes_allocated=%zu bytes_copied=%zu "
+          "peak_available=%zu slack=%zu\n",
+          stats->grows, stats->shrinks, stats->bytes_allocated,
+          stats->bytes_copied, stats->peak_available, slack);
+}
+#else
+#define __PRICK_DARR_STATS_RESIZE(DARR, OLD, NEW, COPIED) ((void)0)
+#endif
+
+#ifdef PRICK_DARR_PROFILE
+static prick_darr_site_t __prick_darr_sites[PRICK_DARR_PROFILE_SITES];
+static size_t __prick_darr_site_count;
+
+// Arrays may be made and grown on several threads at once, so the
+// table of sites is locked and counters are updated atomically
+#if defined(__GNUC__) || defined(__clang__)
+static char __prick_darr_site_lock;
+#define __PRICK_DARR_SITE_LOCK()                                             \
+  while (__atomic_test_and_set(&__prick_darr_site_lock, __ATOMIC_ACQUIRE)) \
+    continue
+#define __PRICK_DARR_SITE_UNLOCK() \
+  __atomic_clear(&__prick_darr_site_lock, __ATOMIC_RELEASE)
+#define __PRICK_DARR_SITE_INC(FIELD) \
+  ((void)__atomic_fetch_add(&(FIELD), 1, __ATOMIC_RELAXED))
+
+static void __prick_darr_site_max(size_t *field, size_t n)
+{
+  size_t old = __atomic_load_n(field, __ATOMIC_RELAXED);
+  while (old < n && !__atomic_compare_exchange_n(field, &old, n, 1,
+                                                 __ATOMIC_RELAXED,
+                                                 __ATOMIC_RELAXED))
+    continue;
+}
+#else
+#define __PRICK_DARR_SITE_LOCK()     ((void)0)
+#define __PRICK_DARR_SITE_UNLOCK()   ((void)0)
+#define __PRICK_DARR_SITE_INC(FIELD) ((void)++(FIELD))
+
+static void __prick_darr_site_max(size_t *field, size_t n)
+{
+  *field = __PRICK_DARR_MAX(*field, n);
+}
+#endif
+
+static prick_darr_site_t *__prick_darr_site(const char *file, int line,
+                                            const void *pc)
+{
+  prick_darr_site_t *site = NULL;
+  __PRICK_DARR_SITE_LOCK();
+  for (size_t i = 0; i < __prick_darr_site_count && !site; ++i)
+  {
+    prick_darr_site_t *other = __prick_darr_sites + i;
+    if (other->line == line && other->pc == pc &&
+        (other->file == file ||
+         (other->file && file && strcmp(other->file, file) == 0)))
+      site = other;
+  }
+  if (!site && __prick_darr_site_count < PRICK_DARR_PROFILE_SITES)
+  {
+    site       = __prick_darr_sites + __prick_darr_site_count++;
+    site->file = file;
+    site->line = line;
+    site->pc   = pc;
+  }
+  __PRICK_DARR_SITE_UNLOCK();
+  return site;
+}
+
+// Attributes the freshly initialised dynamic array to the site given
+static void __prick_darr_attribute(prick_darr_t *darr, const char *file,
+                                   int line)
+{
+  darr->site = __prick_darr_site(file, line, NULL);
+  if (darr->site)
+    __PRICK_DARR_SITE_INC(darr->site->arrays);
+}
+
+static size_t __prick_darr_site_bucket(size_t used)
+{
+  if (used == 0)
+    return 0;
+  size_t bucket = 1;
+  for (size_t cap = 1; cap && cap < used; cap <<= 1)
+    ++bucket;
+  return bucket;
+}
+
+static void __prick_darr_site_free(prick_darr_t *darr)
+{
+  if (!darr->site)
+    return;
+  prick_darr_site_t *site = darr->site;
+  size_t bucket           = __prick_darr_site_bucket(darr->used);
+  __prick_darr_site_max(&site->max_used, darr->used);
+  __PRICK_DARR_SITE_INC(site->freed);
+  __PRICK_DARR_SITE_INC(site->final_sizes[bucket]);
+}
+
+void __prick_darr_claim(prick_darr_t *darr, const char *file, int line)
+{
+  if (!darr->site)
+    __prick_darr_attribute(darr, file, line);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline)) void __prick_darr_claim_caller(prick_darr_t *darr)
+{
+  if (!darr->site && (darr->site = __prick_darr_site(
+                          NULL, 0, __builtin_return_address(0))))
+    __PRICK_DARR_SITE_INC(darr->site->arrays);
+}
+#endif
+
+void __prick_darr_init_site(prick_darr_t *darr, size_t member_size,
+                            const char *file, int line)
+{
+  prick_darr_init(darr, member_size);
+  if (darr)
+    __prick_darr_attribute(darr, file, line);
+}
+
+void __prick_darr_init_allocator_site(prick_darr_t *darr, size_t member_size,
+                                      const prick_darr_allocator_t *allocator,
+                                      void *ctx, const char *file, int line)
+{
+  prick_darr_init_allocator(darr, member_size, allocator, ctx);
+  if (darr)
+    __prick_darr_attribute(darr, file, line);
+}
+
+#ifdef PRICK_DARR_HAS_ALIGNED
+void __prick_darr_init_aligned_site(prick_darr_t *darr, size_t member_size,
+                                    size_t align, const char *file, int line)
+{
+  prick_darr_init_aligned(darr, member_size, align);
+  if (darr)
+    __prick_darr_attribute(darr, file, line);
+}
+#endif
+
+#ifdef PRICK_DARR_HAS_MMAP
+void __prick_darr_init_vmem_site(prick_darr_t *darr, size_t member_size,
+                                 size_t max_members, const char *file,
+                                 int line)
+{
+  prick_darr_init_vmem(darr, member_size, max_members);
+  if (darr)
+    __prick_darr_attribute(darr, file, line);
+}
+
+int __prick_darr_init_file_site(prick_darr_t *darr, size_t member_size,
+                                int fd, const char *file, int line)
+{
+  if (prick_darr_init_file(darr, member_size, fd) != 0)
+    return -1;
+  __prick_darr_attribute(darr, file, line);
+  return 0;
+}
+#endif
+
+#ifdef PRICK_DARR_HAS_MREMAP
+void __prick_darr_init_mremap_site(prick_darr_t *darr, size_t member_size,
+                                   size_t threshold, const char *file,
+                                   int line)
+{
+  prick_darr_init_mremap(darr, member_size, threshold);
+  if (darr)
+    __prick_darr_attribute(darr, file, line);
+}
+#endif
+
+void __prick_darr_init_lazy_site(prick_darr_t *darr, size_t member_size,
+                                 const char *file, int line)
+{
+  prick_darr_init_lazy(darr, member_size);
+  if (darr)
+    __prick_darr_attribute(darr, file, line);
+}
+
+void __prick_darr_init_inline_site(prick_darr_t *darr, size_t member_size,
+                                   void *buffer, size_t buffer_members,
+                                   const char *file, int line)
+{
+  prick_darr_init_inline(darr, member_size, buffer, buffer_members);
+  if (darr)
+    __prick_darr_attribute(darr, file, line);
+}
+
+int __prick_darr_adopt_site(prick_darr_t *darr, size_t member_size,
+                            void *buffer, size_t used, size_t available,
+                            const char *file, int line)
+{
+  return __prick_darr_adopt_allocator_site(darr, member_size, buffer, used,
+                                           available, NULL, NULL, file, line);
+}
+
+int __prick_darr_adopt_allocator_site(prick_darr_t *darr, size_t member_size,
+                                      void *buffer, size_t used,
+                                      size_t available,
+                                      const prick_darr_allocator_t *allocator,
+                                      void *ctx, const char *file, int line)
+{
+  int ret = prick_darr_adopt_allocator(darr, member_size, buffer, used,
+                                       available, allocator, ctx);
+  if (darr)
+    __prick_darr_attribute(darr, file, line);
+  return ret;
+}
+
+int __prick_darr_ensure_capacity_site(prick_darr_t *darr, size_t requested,
+                                      const char *file, int line)
+{
+  __prick_darr_claim(darr, file, line);
+  return prick_darr_ensure_capacity(darr, requested);
+}
+
+int __prick_darr_append_site(prick_darr_t *darr, void *ptr, const char *file,
+                             int line)
+{
+  __prick_darr_claim(darr, file, line);
+  return prick_darr_append(darr, ptr);
+}
+
+int __prick_darr_append_n_site(prick_darr_t *darr, void *ptr, size_t n,
+                               const char *file, int line)
+{
+  __prick_darr_claim(darr, file, line);
+  return prick_darr_append_n(darr, ptr, n);
+}
+
+int __prick_darr_insert_n_site(prick_darr_t *darr, void *ptr, size_t n,
+                               size_t index, const char *file, int line)
+{
+  __prick_darr_claim(darr, file, line);
+  return prick_darr_insert_n(darr, ptr, n, index);
+}
+
+int __prick_darr_insert_many_site(prick_darr_t *darr, void *ptr, size_t n,
+                                  const size_t *indices, const char *file,
+                                  int line)
+{
+  __prick_darr_claim(darr, file, line);
+  return prick_darr_insert_many(darr, ptr, n, indices);
+}
+
+void prick_darr_profile_dump(FILE *fp)
+{
+  __PRICK_DARR_SITE_LOCK();
+  size_t count = __prick_darr_site_count;
+  __PRICK_DARR_SITE_UNLOCK();
+  for (size_t i = 0; i < count; ++i)
+  {
+    const prick_darr_site_t *site = __prick_darr_sites + i;
+    size_t covered = 0, bucket = 0;
+    for (; bucket < sizeof(site->final_sizes) / sizeof(site->final_sizes[0]);
+         ++bucket)
+    {
+      covered += site->final_sizes[bucket];
+      if (covered * 10 >= site->freed * 9)
+        break;
+    }
+    size_t recommended = bucket == 0 ? 0 : (size_t)1 << (bucket - 1);
+    if (site->file)
+      fprintf(fp, "%s:%d ", site->file, site->line);
+    else
+      fprintf(fp, "pc=%p ", (void *)site->pc);
+    fprintf(fp,
+            "arrays=%zu grows=%zu freed=%zu max_used=%zu recommended=%zu\n",
+            site->arrays, site->grows, site->freed, site->max_used,
+            recommended);
+  }
+}
+#endif
+
+static uint8_t *__prick_darr_alloc(prick_darr_t *darr, size_t size)
+{
+  if (darr->allocator)
+    return (uint8_t *)darr->allocator->alloc(darr->allocator_ctx, size);
+  return (uint8_t *)malloc(size);
+}
+
+static uint8_t *__prick_darr_realloc(prick_darr_t *darr, void *ptr,
+                                     size_t old_size, size_t new_size)
+{
+  if (!ptr)
+    return __prick_darr_alloc(darr, new_size);
+  if (darr->allocator)
+    return (uint8_t *)darr->allocator->realloc(darr->allocator_ctx, ptr,
+                                               old_size, new_size);
+  return (uint8_t *)realloc(ptr, new_size);
+}
+
+static void __prick_darr_dealloc(prick_darr_t *darr, void *ptr, size_t size)
+{
+  if (darr->allocator)
+    darr->allocator->free(darr->allocator_ctx, ptr, size);
+  else
+    free(ptr);
+}
+
+// Caps a capacity to the largest the allocator can give, where offset
+// is the number of bytes before the first member in the allocation
+static size_t __prick_darr_clamp(const prick_darr_t *darr, size_t available,
+                                 size_t offset)
+{
+  if (!darr->allocator || !darr->allocator->max_size)
+    return available;
+  size_t max = darr->allocator->max_size(darr->allocator_ctx);
+  max        = max > offset ? (max - offset) / darr->size : 0;
+  return __PRICK_DARR_MIN(available, max);
+}
+
+#define __PRICK_DARR_ALIGN_UP(n, align) (((n) + (align) - 1) & ~((align) - 1))
+
+/**
+ * With PRICK_DARR_HAS_USABLE_SIZE, libc allocations are sized to fill
+ * malloc's size classes: capacities are rounded up to what a chunk of
+ * that size holds before allocating, and afterwards raised to
+ * whatever malloc_usable_size reports (e.g. page rounding of large
+ * allocations), so slack malloc gives us anyway is used before the
+ * next realloc.  Only libc allocations (no allocator) of arrays
+ * without PRICK_DARR_FLAG_EXACT are affected.  Offset is the number of
+ * bytes before the first member in the allocation.
+ */
+#ifdef PRICK_DARR_HAS_USABLE_SIZE
+static int __prick_darr_slack(const prick_darr_t *darr)
+{
+  return !darr->allocator && !(darr->flags & PRICK_DARR_FLAG_EXACT) &&
+         darr->size;
+}
+
+static size_t __prick_darr_size_class(const prick_darr_t *darr,
+                                      size_t available, size_t offset)
+{
+  if (!__prick_darr_slack(darr))
+    return available;
+#ifdef __GLIBC__
+  // Chunks are a multiple of 2 * sizeof(size_t), one size_t of which
+  // is the chunk header
+  size_t bytes = __PRICK_DARR_ALIGN_UP(offset + (available * darr->size) +
+                                           sizeof(size_t),
+                                       2 * sizeof(size_t)) -
+                 sizeof(size_t);
+#else
+  size_t bytes = __PRICK_DARR_ALIGN_UP(offset + (available * darr->size), 16);
+#endif
+  return (bytes - offset) / darr->size;
+}
+
+static size_t __prick_darr_usable(const prick_darr_t *darr, void *ptr,
+                                  size_t available, size_t offset)
+{
+  if (!ptr || !__prick_darr_slack(darr))
+    return available;
+  size_t members = (__PRICK_DARR_USABLE_SIZE(ptr) - offset) / darr->size;
+  return __PRICK_DARR_MAX(available, members);
+}
+#else
+#define __prick_darr_size_class(DARR, AVAILABLE, OFFSET) (AVAILABLE)
+#define __prick_darr_usable(DARR, PTR, AVAILABLE, OFFSET) (AVAILABLE)
+#endif
+
+#ifdef PRICK_DARR_HAS_ALIGNED
+static void *__prick_darr_aligned_alloc(void *ctx, size_t size)
+{
+  size_t align = (size_t)(uintptr_t)ctx;
+  size         = __PRICK_DARR_ALIGN_UP(size, align);
+#ifdef __PRICK_DARR_POSIX_MEMALIGN
+  // posix_memalign wants at least pointer alignment, which malloc gives
+  if (align < sizeof(void *))
+    return malloc(size);
+  void *ptr = NULL;
+  return posix_memalign(&ptr, align, size) ? NULL : ptr;
+#else
+  return aligned_alloc(align, size);
+#endif
+}
+
+static void *__prick_darr_aligned_realloc(void *ctx, void *ptr,
+                                          size_t old_size, size_t new_size)
+{
+  // A misaligned block from realloc can't be given back without
+  // losing the old one, so always copy into a fresh aligned block
+  void *aligned = __prick_darr_aligned_alloc(ctx, new_size);
+  if (!aligned)
+    return NULL;
+  if (ptr)
+    memcpy(aligned, ptr, __PRICK_DARR_MIN(old_size, new_size));
+  free(ptr);
+  return aligned;
+}
+
+static void __prick_darr_aligned_free(void *ctx, void *ptr, size_t size)
+{
+  (void)ctx;
+  (void)size;
+  free(ptr);
+}
+
+const prick_darr_allocator_t prick_darr_aligned_allocator = {
+    __prick_darr_aligned_alloc,
+    __prick_darr_aligned_realloc,
+    __prick_darr_aligned_free,
+    NULL, // max_size
+};
+#endif
+
+#ifdef PRICK_DARR_HAS_MMAP
+#if !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#if !defined(MAP_NORESERVE)
+#define MAP_NORESERVE 0
+#endif
+
+static size_t __prick_darr_page_up(size_t size)
+{
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  return __PRICK_DARR_ALIGN_UP(size, page);
+}
+
+static void *__prick_darr_vmem_alloc(void *ctx, size_t size)
+{
+  size_t reserve = __prick_darr_page_up((size_t)(uintptr_t)ctx);
+  if (size > reserve)
+    return NULL;
+  uint8_t *base = (uint8_t *)mmap(NULL, reserve, PROT_NONE,
+                                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                                  -1, 0);
+  if (base == MAP_FAILED)
+    return NULL;
+  size = __prick_darr_page_up(size);
+  if (size && mprotect(base, size, PROT_READ | PROT_WRITE) != 0)
+  {
+    munmap(base, reserve);
+    return NULL;
+  }
+  return base;
+}
+
+static void *__prick_darr_vmem_realloc(void *ctx, void *ptr, size_t old_size,
+                                       size_t new_size)
+{
+  size_t reserve = __prick_darr_page_up((size_t)(uintptr_t)ctx);
+  if (new_size > reserve)
+    return NULL;
+  uint8_t *base = (uint8_t *)ptr;
+  old_size      = __prick_darr_page_up(old_size);
+  new_size      = __prick_darr_page_up(new_size);
+  if (new_size > old_size)
+  {
+    if (mprotect(base + old_size, new_size - old_size,
+                 PROT_READ | PROT_WRITE) != 0)
+      return NULL;
+  }
+  else if (new_size < old_size)
+  {
+    // Give the pages back, then make them inaccessible again
+    mmap(base + new_size, old_size - new_size, PROT_NONE,
+         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+  }
+  return base;
+}
+
+static void __prick_darr_vmem_free(void *ctx, void *ptr, size_t size)
+{
+  (void)size;
+  munmap(ptr, __prick_darr_page_up((size_t)(uintptr_t)ctx));
+}
+
+static size_t __prick_darr_vmem_max_size(void *ctx)
+{
+  return __prick_darr_page_up((size_t)(uintptr_t)ctx);
+}
+
+const prick_darr_allocator_t prick_darr_vmem_allocator = {
+    __prick_darr_vmem_alloc,
+    __prick_darr_vmem_realloc,
+    __prick_darr_vmem_free,
+    __prick_darr_vmem_max_size, // max_size
+};
+
+#define __PRICK_DARR_FILE_MAGIC "prickdar"
+
+// First page of a file backed dynamic array
+typedef struct
+{
+  char magic[8];
+  uint64_t size; // size of each member
+  uint64_t used; // members in use as of the last sync
+} __prick_darr_file_header_t;
+
+// Bytes of file (and mapping) for storage of the given size
+static size_t __prick_darr_file_length(size_t size)
+{
+  return __prick_darr_page_up(1) + __prick_darr_page_up(size);
+}
+
+// Makes the file at least length bytes long
+static int __prick_darr_file_extend(int fd, size_t length)
+{
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+    return -1;
+  if ((size_t)st.st_size >= length)
+    return 0;
+#ifdef FALLOC_FL_KEEP_SIZE
+  if (fallocate(fd, 0, 0, (off_t)length) == 0)
+    return 0;
+  if (errno != EOPNOTSUPP)
+    return -1;
+#endif
+  return ftruncate(fd, (off_t)length);
+}
+
+static uint8_t *__prick_darr_file_map(int fd, size_t length)
+{
+  void *map =
+      mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  return map == MAP_FAILED ? NULL
+                           : (uint8_t *)map + __prick_darr_page_up(1);
+}
+
+static void *__prick_darr_file_alloc(void *ctx, size_t size)
+{
+  int fd        = (int)(intptr_t)ctx;
+  size_t length = __prick_darr_file_length(size);
+  if (__prick_darr_file_extend(fd, length) != 0)
+    return NULL;
+  return __prick_darr_file_map(fd, length);
+}
+
+static void *__prick_darr_file_realloc(void *ctx, void *ptr, size_t old_size,
+                                       size_t new_size)
+{
+  int fd            = (int)(intptr_t)ctx;
+  size_t page       = __prick_darr_page_up(1);
+  size_t old_length = __prick_darr_file_length(old_size);
+  size_t new_length = __prick_darr_file_length(new_size);
+  uint8_t *base     = (uint8_t *)ptr - page;
+  if (new_length == old_length)
+    return ptr;
+  if (new_length > old_length && __prick_darr_file_extend(fd, new_length) != 0)
+    return NULL;
+  // Members live in the file, so a new mapping of it has them already
+#ifdef PRICK_DARR_HAS_MREMAP
+  void *map = mremap(base, old_length, new_length, MREMAP_MAYMOVE);
+  uint8_t *data = map == MAP_FAILED ? NULL : (uint8_t *)map + page;
+#else
+  uint8_t *data = __prick_darr_file_map(fd, new_length);
+  if (data)
+    munmap(base, old_length);
+#endif
+  // A file longer than its mapping is harmless, so failing to shrink
+  // it isn't an error.  The header mustn't claim members past the new
+  // end though, or the file couldn't be opened again.
+  if (data && new_length < old_length)
+  {
+    __prick_darr_file_header_t *header =
+        (__prick_darr_file_header_t *)(data - page);
+    uint64_t members = new_size / header->size;
+    if (header->used > members)
+    {
+      header->used = members;
+      if (msync(header, page, MS_SYNC) != 0)
+        return data;
+    }
+    (void)!ftruncate(fd, (off_t)new_length);
+  }
+  return data;
+}
+
+static void __prick_darr_file_free(void *ctx, void *ptr, size_t size)
+{
+  (void)ctx;
+  munmap((uint8_t *)ptr - __prick_darr_page_up(1),
+         __prick_darr_file_length(size));
+}
+
+const prick_darr_allocator_t prick_darr_file_allocator = {
+    __prick_darr_file_alloc,
+    __prick_darr_file_realloc,
+    __prick_darr_file_free,
+    NULL, // max_size
+};
+
+static __prick_darr_file_header_t *__prick_darr_file_header(
+    const prick_darr_t *darr)
+{
+  return (__prick_darr_file_header_t *)(darr->data -
+                                        __prick_darr_page_up(1));
+}
+
+int prick_darr_init_file(prick_darr_t *darr, size_t member_size, int fd)
+{
+  struct stat st;
+  size_t page = __prick_darr_page_up(1);
+  if (!darr || member_size == 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  if (fstat(fd, &st) != 0)
+    return -1;
+  prick_darr_init_lazy(darr, member_size);
+  darr->allocator     = &prick_darr_file_allocator;
+  darr->allocator_ctx = (void *)(intptr_t)fd;
+  if (st.st_size == 0)
+  {
+    darr->data = (uint8_t *)__prick_darr_file_alloc(
+        darr->allocator_ctx, PRICK_DARR_DEFAULT_SIZE * member_size);
+    if (!darr->data)
+      return -1;
+    darr->available                     = PRICK_DARR_DEFAULT_SIZE;
+    __prick_darr_file_header_t *header = __prick_darr_file_header(darr);
+    memcpy(header->magic, __PRICK_DARR_FILE_MAGIC, sizeof(header->magic));
+    header->size = member_size;
+    header->used = 0;
+    // Otherwise a crash could leave a file that isn't recognised
+    if (msync(header, page, MS_SYNC) != 0)
+    {
+      __prick_darr_file_free(darr->allocator_ctx, darr->data,
+                             darr->available * member_size);
+      darr->data      = NULL;
+      darr->available = 0;
+      return -1;
+    }
+  }
+  else
+  {
+    if ((size_t)st.st_size < page)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+    // May be 0 for a file with just a header, which is still mapped
+    size_t available = ((size_t)st.st_size - page) / member_size;
+    darr->data = __prick_darr_file_map(
+        fd, __prick_darr_file_length(available * member_size));
+    if (!darr->data)
+      return -1;
+    darr->available                     = available;
+    __prick_darr_file_header_t *header = __prick_darr_file_header(darr);
+    if (memcmp(header->magic, __PRICK_DARR_FILE_MAGIC,
+               sizeof(header->magic)) != 0 ||
+        header->size != member_size || header->used > available)
+    {
+      __prick_darr_file_free(darr->allocator_ctx, darr->data,
+                             available * member_size);
+      darr->data = NULL;
+      errno      = EINVAL;
+      return -1;
+    }
+    darr->used = header->used;
+  }
+  __PRICK_DARR_STATS_RESIZE(darr, 0, darr->available * member_size, 0);
+  __PRICK_DARR_STATS_USE(darr, darr->used);
+  return 0;
+}
+
+// Flushes bytes [from, to) of the members to the file
+static int __prick_darr_file_msync(const prick_darr_t *darr, size_t from,
+                                   size_t to)
+{
+  if (from >= to)
+    return 0;
+  size_t page    = __prick_darr_page_up(1);
+  uint8_t *start = darr->data + from;
+  uint8_t *base  = (uint8_t *)((uintptr_t)start & ~(uintptr_t)(page - 1));
+  return msync(base, (size_t)(darr->data + to - base), MS_SYNC);
+}
+
+int prick_darr_sync_file(prick_darr_t *darr)
+{
+  size_t page = __prick_darr_page_up(1);
+  if (darr->allocator != &prick_darr_file_allocator)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  // Tightening an empty array gives up its mapping, header and all
+  uint8_t *data =
+      darr->data ? darr->data
+                 : __prick_darr_file_map((int)(intptr_t)darr->allocator_ctx,
+                                         page);
+  if (!data)
+    return -1;
+  __prick_darr_file_header_t *header =
+      (__prick_darr_file_header_t *)(data - page);
+  int ret = 0;
+  if (header->used < darr->used)
+    ret = __prick_darr_file_msync(darr, header->used * darr->size,
+                                  darr->used * darr->size);
+  if (ret == 0)
+  {
+    header->used = darr->used;
+    ret          = msync(header, page, MS_SYNC);
+  }
+  if (!darr->data)
+    munmap(header, page);
+  return ret;
+}
+
+int prick_darr_sync_file_range(const prick_darr_t *darr, size_t index,
+                               size_t n)
+{
+  if (darr->allocator != &prick_darr_file_allocator || !darr->data ||
+      darr->used < (index + n))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  return __prick_darr_file_msync(darr, index * darr->size,
+                                 (index + n) * darr->size);
+}
+#endif
+
+#ifdef PRICK_DARR_HAS_MREMAP
+static size_t __prick_darr_mremap_threshold(void *ctx)
+{
+  return ctx ? (size_t)(uintptr_t)ctx : PRICK_DARR_MREMAP_THRESHOLD;
+}
+
+static void *__prick_darr_mmap(size_t size)
+{
+  void *ptr = mmap(NULL, __prick_darr_page_up(size), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+static void *__prick_darr_mremap_alloc(void *ctx, size_t size)
+{
+  if (size >= __prick_darr_mremap_threshold(ctx))
+    return __prick_darr_mmap(size);
+  return malloc(size);
+}
+
+static void *__prick_darr_mremap_realloc(void *ctx, void *ptr,
+                                         size_t old_size, size_t new_size)
+{
+  // Whether a block is mapped is decided purely by its size, so old
+  // and new sizes tell us which kind of block we're moving between
+  size_t threshold = __prick_darr_mremap_threshold(ctx);
+  int old_mapped = old_size >= threshold, new_mapped = new_size >= threshold;
+  void *new_ptr;
+  if (!old_mapped && !new_mapped)
+    return realloc(ptr, new_size);
+  else if (old_mapped && new_mapped)
+  {
+    new_ptr = mremap(ptr, __prick_darr_page_up(old_size),
+                     __prick_darr_page_up(new_size), MREMAP_MAYMOVE);
+    return new_ptr == MAP_FAILED ? NULL : new_ptr;
+  }
+  else if (new_mapped)
+  {
+    new_ptr = __prick_darr_mmap(new_size);
+    if (new_ptr)
+    {
+      memcpy(new_ptr, ptr, old_size);
+      free(ptr);
+    }
+    return new_ptr;
+  }
+  new_ptr = malloc(new_size);
+  if (new_ptr)
+  {
+    memcpy(new_ptr, ptr, new_size);
+    munmap(ptr, __prick_darr_page_up(old_size));
+  }
+  return new_ptr;
+}
+
+static void __prick_darr_mremap_free(void *ctx, void *ptr, size_t size)
+{
+  if (size >= __prick_darr_mremap_threshold(ctx))
+    munmap(ptr, __prick_darr_page_up(size));
+  else
+    free(ptr);
+}
+
+const prick_darr_allocator_t prick_darr_mremap_allocator = {
+    __prick_darr_mremap_alloc,
+    __prick_darr_mremap_realloc,
+    __prick_darr_mremap_free,
+    NULL, // max_size
+};
+#endif
+
+void prick_darr_init(prick_darr_t *darr, size_t member_size)
+{
+  prick_darr_init_allocator(darr, member_size, NULL, NULL);
+}
+
+void prick_darr_init_allocator(prick_darr_t *darr, size_t member_size,
+                               const prick_darr_allocator_t *allocator,
+                               void *ctx)
+{
+  if (!darr)
+    return;
+  prick_darr_init_lazy(darr, member_size);
+  darr->allocator     = allocator;
+  darr->allocator_ctx = ctx;
+  darr->available     = __prick_darr_clamp(
+      darr, __prick_darr_size_class(darr, PRICK_DARR_DEFAULT_SIZE, 0), 0);
+  darr->data = __prick_darr_alloc(darr, member_size * darr->available);
+  // Without storage the dynamic array is left empty, as if lazy
+  darr->available = darr->data ? __prick_darr_usable(darr, darr->data,
+                                                     darr->available, 0)
+                               : 0;
+  __PRICK_DARR_STATS_RESIZE(darr, 0, member_size * darr->available, 0);
+}
+
+#ifdef PRICK_DARR_HAS_ALIGNED
+void prick_darr_init_aligned(prick_darr_t *darr, size_t member_size,
+                             size_t align)
+{
+  prick_darr_init_allocator(darr, member_size, &prick_darr_aligned_allocator,
+                            (void *)(uintptr_t)align);
+}
+#endif
+
+#ifdef PRICK_DARR_HAS_MMAP
+void prick_darr_init_vmem(prick_darr_t *darr, size_t member_size,
+                          size_t max_members)
+{
+  prick_darr_init_allocator(darr, member_size, &prick_darr_vmem_allocator,
+                            (void *)(uintptr_t)(max_members * member_size));
+}
+#endif
+
+#ifdef PRICK_DARR_HAS_MREMAP
+void prick_darr_init_mremap(prick_darr_t *darr, size_t member_size,
+                            size_t threshold)
+{
+  prick_darr_init_allocator(darr, member_size, &prick_darr_mremap_allocator,
+                            (void *)(uintptr_t)threshold);
+}
+#endif
+
+void prick_darr_init_lazy(prick_darr_t *darr, size_t member_size)
+{
+  if (!darr)
+    return;
+  // Zeroes every member, including those only present with
+  // PRICK_DARR_STATS or PRICK_DARR_PROFILE
+  memset(darr, 0, sizeof(*darr));
+  darr->size = member_size;
+}
+
+void prick_darr_init_inline(prick_darr_t *darr, size_t member_size,
+                            void *buffer, size_t buffer_members)
+{
+  if (!darr)
+    return;
+  prick_darr_init_lazy(darr, member_size);
+  darr->available = buffer_members;
+  darr->data      = (uint8_t *)buffer;
+  darr->flags     = PRICK_DARR_FLAG_INLINE;
+}
+
+static size_t __prick_darr_grow(const prick_darr_t *darr, size_t requested)
+{
+  if (darr->available == 0)
+    return __PRICK_DARR_MAX(PRICK_DARR_DEFAULT_SIZE, darr->used + requested);
+  size_t available = darr->available * PRICK_DARR_ALLOC_MULT;
+  if (darr->growth)
+    switch (darr->growth->kind)
+    {
+    case PRICK_DARR_GROWTH_MULT:
+      available = (size_t)(darr->available * darr->growth->factor);
+      break;
+    case PRICK_DARR_GROWTH_ADD:
+      available = darr->available + darr->growth->step;
+      break;
+    case PRICK_DARR_GROWTH_FN:
+      available = darr->growth->fn(darr->used, requested, darr->available);
+      break;
+    }
+  return __PRICK_DARR_MAX(available, darr->used + requested);
+}
+
+// Capacity to grow to: the growth policy's, rounded up to malloc's
+// size classes and clamped to what the allocator can give (so less
+// than used + requested if it can't grow)
+static size_t __prick_darr_grow_capacity(const prick_darr_t *darr,
+                                         size_t requested, size_t offset)
+{
+  size_t available = __prick_darr_size_class(
+      darr, __prick_darr_grow(darr, requested), offset);
+  return __prick_darr_clamp(darr, available, offset);
+}
+
+int prick_darr_adopt(prick_darr_t *darr, size_t member_size, void *buffer,
+                     size_t used, size_t available)
+{
+  return prick_darr_adopt_allocator(darr, member_size, buffer, used,
+                                    available, NULL, NULL);
+}
+
+int prick_darr_adopt_allocator(prick_darr_t *darr, size_t member_size,
+                               void *buffer, size_t used, size_t available,
+                               const prick_darr_allocator_t *allocator,
+                               void *ctx)
+{
+  if (!darr)
+    return -1;
+  prick_darr_init_lazy(darr, member_size);
+  // Bad arguments leave the dynamic array empty, not owning the buffer
+  if (used > available || (!buffer && available))
+    return -1;
+  darr->allocator     = allocator;
+  darr->allocator_ctx = ctx;
+  darr->data          = (uint8_t *)buffer;
+  darr->used          = used;
+  darr->available     = __prick_darr_usable(darr, buffer, available, 0);
+  __PRICK_DARR_STATS_RESIZE(darr, 0, darr->available * member_size, 0);
+  __PRICK_DARR_STATS_USE(darr, used);
+  return 0;
+}
+
+void prick_darr_set_growth(prick_darr_t *darr,
+                           const prick_darr_growth_t *growth)
+{
+  darr->growth = growth;
+}
+
+void prick_darr_free(prick_darr_t *darr, void (*mem_free)(void *))
+{
+#ifdef PRICK_DARR_PROFILE
+  __prick_darr_site_free(darr);
+#endif
+  if (mem_free)
+    for (size_t i = 0; i < darr->used; ++i)
+      mem_free(darr->data + (i * darr->size));
+  __PRICK_DARR_STATS_UNUSE(darr, darr->used);
+  if (darr->data && !(darr->flags & PRICK_DARR_FLAG_INLINE))
+  {
+    __PRICK_DARR_STATS_RESIZE(darr, darr->available * darr->size, 0, 0);
+    __prick_darr_dealloc(darr, darr->data, darr->available * darr->size);
+  }
+}
+
+int prick_darr_ensure_capacity(prick_darr_t *darr, size_t requested)
+{
+  if (darr->used + requested <= darr->available)
+    return 0;
+  size_t available = __prick_darr_grow_capacity(darr, requested, 0);
+  if (available < darr->used + requested)
+    return -1;
+  if (darr->flags & PRICK_DARR_FLAG_INLINE)
+  {
+    // Spill to the heap; the inline buffer is left untouched
+    uint8_t *data = __prick_darr_alloc(darr, available * darr->size);
+    if (!data)
+      return -1;
+    available = __prick_darr_usable(darr, data, available, 0);
+    memcpy(data, darr->data, darr->used * darr->size);
+    __PRICK_DARR_STATS_RESIZE(darr, 0, available * darr->size,
+                              darr->used * darr->size);
+    darr->data = data;
+    darr->flags &= ~PRICK_DARR_FLAG_INLINE;
+  }
+  else
+  {
+    uint8_t *data = __prick_darr_realloc(darr, darr->data,
+                                         darr->available * darr->size,
+                                         available * darr->size);
+    // The policy may overshoot what the allocator can give (e.g. a
+    // fixed reservation), so fall back to just what was asked for
+    if (!data && available > darr->used + requested)
+    {
+      available = darr->used + requested;
+      data      = __prick_darr_realloc(darr, darr->data,
+                                       darr->available * darr->size,
+                                       available * darr->size);
+    }
+    // The old storage is still valid (and ours) if realloc failed
+    if (!data)
+      return -1;
+    available = __prick_darr_usable(darr, data, available, 0);
+    __PRICK_DARR_STATS_RESIZE(
+        darr, darr->available * darr->size, available * darr->size,
+        data == darr->data ? 0 : darr->available * darr->size);
+    darr->data = data;
+  }
+#ifdef PRICK_DARR_PROFILE
+  // Only members actually held count towards max_used, not the
+  // capacity asked for; free and release record the final size
+  if (darr->site)
+  {
+    __PRICK_DARR_SITE_INC(darr->site->grows);
+    __prick_darr_site_max(&darr->site->max_used, darr->used);
+  }
+#endif
+  darr->available = available;
+  return 0;
+}
+
+void prick_darr_tighten(prick_darr_t *darr)
+{
+  // Inline storage can't be given back
+  if (darr->used >= darr->available || (darr->flags & PRICK_DARR_FLAG_INLINE))
+    return;
+  if (darr->used == 0)
+  {
+    __prick_darr_dealloc(darr, darr->data, darr->available * darr->size);
+    darr->data = NULL;
+  }
+  else
+  {
+    uint8_t *data =
+        __prick_darr_realloc(darr, darr->data, darr->available * darr->size,
+                             darr->used * darr->size);
+    // Keep the larger storage if the allocator couldn't shrink it
+    if (!data)
+      return;
+    darr->data = data;
+  }
+  __PRICK_DARR_STATS_RESIZE(darr, darr->available * darr->size,
+                            darr->used * darr->size, 0);
+  darr->available = darr->used;
+}
+
+void *prick_darr_release(prick_darr_t *darr, size_t *len, size_t *available,
+                         int tighten)
+{
+  if (darr->flags & PRICK_DARR_FLAG_INLINE)
+  {
+    uint8_t *data = __prick_darr_alloc(darr, darr->used * darr->size);
+    if (!data && darr->used)
+      return NULL;
+    if (darr->used)
+      memcpy(data, darr->data, darr->used * darr->size);
+    darr->data      = data;
+    darr->available = darr->used;
+    darr->flags &= ~PRICK_DARR_FLAG_INLINE;
+    __PRICK_DARR_STATS_RESIZE(darr, 0, darr->available * darr->size,
+                              darr->used * darr->size);
+  }
+  else if (tighten)
+  {
+    prick_darr_tighten(darr);
+    // The allocator couldn't shrink the storage
+    if (darr->available != darr->used)
+      return NULL;
+  }
+#ifdef PRICK_DARR_PROFILE
+  __prick_darr_site_free(darr);
+  darr->site = NULL;
+#endif
+  void *data = darr->data;
+  if (len)
+    *len = darr->used;
+  if (available)
+    *available = darr->available;
+  __PRICK_DARR_STATS_UNUSE(darr, darr->used);
+  __PRICK_DARR_STATS_RESIZE(darr, darr->available * darr->size, 0, 0);
+  darr->data      = NULL;
+  darr->used      = 0;
+  darr->available = 0;
+  return data;
+}
+
+int prick_darr_append(prick_darr_t *darr, void *ptr)
+{
+  if (prick_darr_ensure_capacity(darr, 1))
+    return -1;
+  memcpy(darr->data + (darr->used * darr->size), ptr, darr->size);
+  ++darr->used;
+  __PRICK_DARR_STATS_USE(darr, 1);
+  return 0;
+}
+
+int prick_darr_append_n(prick_darr_t *darr, void *ptr, size_t n)
+{
+  if (n == 0)
+    return 0;
+  if (prick_darr_ensure_capacity(darr, n))
+    return -1;
   memcpy(darr->data + (darr->used * darr->size), ptr, n * darr->size);
   darr->used += n;
+  __PRICK_DARR_STATS_USE(darr, n);
+  return 0;
 }
 
 void prick_darr_write(prick_darr_t *darr, void *ptr, size_t index)
@@ -210,11 +2454,649 @@ void prick_darr_write(prick_darr_t *darr, void *ptr, size_t index)
 
 void prick_darr_write_n(prick_darr_t *darr, void *ptr, size_t n, size_t index)
 {
-  if (darr->used <= (n + index))
+  if (darr->used < (n + index))
     return;
   memcpy(darr->data + (index * darr->size), ptr, n * darr->size);
 }
 
+int prick_darr_insert_n(prick_darr_t *darr, void *ptr, size_t n, size_t index)
+{
+  if (darr->used < index)
+    return -1;
+  if (n == 0)
+    return 0;
+  if (prick_darr_ensure_capacity(darr, n))
+    return -1;
+  memmove(darr->data + ((index + n) * darr->size),
+          darr->data + (index * darr->size),
+          (darr->used - index) * darr->size);
+  memcpy(darr->data + (index * darr->size), ptr, n * darr->size);
+  darr->used += n;
+  __PRICK_DARR_STATS_USE(darr, n);
+  return 0;
+}
+
+int prick_darr_insert_many(prick_darr_t *darr, void *ptr, size_t n,
+                           const size_t *indices)
+{
+  if (n == 0)
+    return 0;
+  for (size_t i = 0; i < n; ++i)
+    if (indices[i] > darr->used || (i > 0 && indices[i] < indices[i - 1]))
+      return -1;
+  if (prick_darr_ensure_capacity(darr, n))
+    return -1;
+  // Working backwards, members from indices[i] up to the last moved
+  // member shift up by i + 1 (the number of elements inserted at or
+  // before them), leaving a slot for element i just beneath
+  size_t end = darr->used;
+  for (size_t i = n; i-- > 0;)
+  {
+    size_t index = indices[i];
+    memmove(darr->data + ((index + i + 1) * darr->size),
+            darr->data + (index * darr->size), (end - index) * darr->size);
+    memcpy(darr->data + ((index + i) * darr->size),
+           (uint8_t *)ptr + (i * darr->size), darr->size);
+    end = index;
+  }
+  darr->used += n;
+  __PRICK_DARR_STATS_USE(darr, n);
+  return 0;
+}
+
+void prick_darr_erase_range(prick_darr_t *darr, size_t index, size_t n)
+{
+  if (darr->used < (index + n))
+    return;
+  memmove(darr->data + (index * darr->size),
+          darr->data + ((index + n) * darr->size),
+          (darr->used - index - n) * darr->size);
+  darr->used -= n;
+  __PRICK_DARR_STATS_UNUSE(darr, n);
+}
+
+int prick_darr_pop(prick_darr_t *darr, void *out)
+{
+  if (darr->used == 0)
+    return -1;
+  --darr->used;
+  if (out)
+    memcpy(out, darr->data + (darr->used * darr->size), darr->size);
+  __PRICK_DARR_STATS_UNUSE(darr, 1);
+  return 0;
+}
+
+void prick_darr_swap_remove(prick_darr_t *darr, size_t index)
+{
+  if (darr->used <= index)
+    return;
+  --darr->used;
+  if (index != darr->used)
+    memcpy(darr->data + (index * darr->size),
+           darr->data + (darr->used * darr->size), darr->size);
+  __PRICK_DARR_STATS_UNUSE(darr, 1);
+}
+
+void prick_darr_swap_remove_many(prick_darr_t *darr, size_t n,
+                                 const size_t *indices)
+{
+  for (size_t i = 0; i < n; ++i)
+    if (indices[i] >= darr->used || (i > 0 && indices[i] <= indices[i - 1]))
+      return;
+  for (size_t i = n; i-- > 0;)
+    prick_darr_swap_remove(darr, indices[i]);
+}
+
+#ifdef PRICK_DARR_HAS_FD
+ssize_t prick_darr_read_fd(prick_darr_t *darr, int fd, size_t max_bytes)
+{
+  size_t members = (max_bytes + darr->size - 1) / darr->size;
+  if (members == 0)
+    return 0;
+  errno = 0;
+  if (prick_darr_ensure_capacity(darr, members))
+  {
+    errno = errno ? errno : ENOMEM;
+    return -1;
+  }
+  uint8_t *tail = darr->data + (darr->used * darr->size);
+  size_t want = max_bytes, got = 0;
+  while (got < want)
+  {
+    ssize_t n = read(fd, tail + got, want - got);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      // Wait for the rest of a partial member rather than split it
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) && got % darr->size)
+      {
+        struct pollfd pfd;
+        pfd.fd      = fd;
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, -1) >= 0 || errno == EINTR)
+          continue;
+      }
+      if (got == 0)
+        return -1;
+      break;
+    }
+    else if (n == 0)
+      break;
+    got += (size_t)n;
+    if (got % darr->size == 0)
+      break;
+    // Only read the rest of the partial member
+    want = got + darr->size - (got % darr->size);
+  }
+  darr->used += got / darr->size;
+  __PRICK_DARR_STATS_USE(darr, got / darr->size);
+  return (ssize_t)got;
+}
+
+ssize_t prick_darr_read_fd_all(prick_darr_t *darr, int fd)
+{
+  struct stat st;
+  off_t offset;
+  int sized = 0;
+  // One more member than the rest of the file, so the read that sees
+  // EOF doesn't need to grow the array
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+      (offset = lseek(fd, 0, SEEK_CUR)) >= 0 && st.st_size > offset)
+  {
+    // Otherwise fall back to reading in chunks
+    sized = prick_darr_ensure_capacity(
+                darr, ((size_t)(st.st_size - offset) / darr->size) + 1) == 0;
+  }
+
+  size_t total = 0;
+  while (1)
+  {
+    size_t space = (darr->available - darr->used) * darr->size;
+    if (space == 0 || (!sized && space < PRICK_DARR_READ_CHUNK))
+    {
+      errno = 0;
+      // Short of a chunk is fine while there's some space to read into
+      if (prick_darr_ensure_capacity(
+              darr, __PRICK_DARR_MAX(1, PRICK_DARR_READ_CHUNK / darr->size)) &&
+          space == 0)
+      {
+        errno = errno ? errno : ENOMEM;
+        return -1;
+      }
+    }
+    ssize_t n = prick_darr_read_fd(darr, fd,
+                                   (darr->available - darr->used) *
+                                       darr->size);
+    if (n < 0)
+      return -1;
+    total += (size_t)n;
+    // A partial member means EOF (or an error) cut it short
+    if (n == 0 || (size_t)n % darr->size)
+      break;
+  }
+  return (ssize_t)total;
+}
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// Waits for fd to be writable after EAGAIN, returning 0 on success
+static int __prick_darr_wait_out(int fd)
+{
+  struct pollfd pfd;
+  pfd.fd      = fd;
+  pfd.events  = POLLOUT;
+  pfd.revents = 0;
+  return poll(&pfd, 1, -1) < 0 && errno != EINTR ? -1 : 0;
+}
+
+// Writes every byte referenced by iov (which is consumed as it goes)
+// with as few writev calls as possible
+static ssize_t __prick_darr_writev_all(int fd, struct iovec *iov, size_t n)
+{
+  size_t total = 0;
+  while (n > 0)
+  {
+    ssize_t wrote = writev(fd, iov, (int)__PRICK_DARR_MIN(n, IOV_MAX));
+    if (wrote < 0)
+    {
+      if (errno == EINTR ||
+          ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+           __prick_darr_wait_out(fd) == 0))
+        continue;
+      return total ? (ssize_t)total : -1;
+    }
+    total += (size_t)wrote;
+    // Skip what was written, resuming in the middle of a buffer
+    size_t left = (size_t)wrote;
+    while (n > 0 && left >= iov->iov_len)
+    {
+      left -= iov->iov_len;
+      ++iov;
+      --n;
+    }
+    if (n > 0)
+    {
+      iov->iov_base = (uint8_t *)iov->iov_base + left;
+      iov->iov_len -= left;
+    }
+  }
+  return (ssize_t)total;
+}
+
+ssize_t prick_darr_write_fd(const prick_darr_t *darr, int fd, size_t index,
+                            size_t n)
+{
+  if (darr->used < (index + n) || n == 0)
+    return 0;
+  struct iovec iov;
+  iov.iov_base = darr->data + (index * darr->size);
+  iov.iov_len  = n * darr->size;
+  return __prick_darr_writev_all(fd, &iov, 1);
+}
+
+ssize_t prick_darr_write_fd_many(const prick_darr_t *darrs, size_t n, int fd)
+{
+  struct iovec *iov = (struct iovec *)malloc(n * sizeof(*iov));
+  size_t count      = 0;
+  if (!iov)
+    return -1;
+  for (size_t i = 0; i < n; ++i)
+    if (darrs[i].used)
+    {
+      iov[count].iov_base = darrs[i].data;
+      iov[count].iov_len  = darrs[i].used * darrs[i].size;
+      ++count;
+    }
+  ssize_t total = __prick_darr_writev_all(fd, iov, count);
+  free(iov);
+  return total;
+}
+
+#ifdef PRICK_DARR_HAS_VMSPLICE
+ssize_t prick_darr_vmsplice_fd(const prick_darr_t *darr, int fd, size_t index,
+                               size_t n)
+{
+  if (darr->used < (index + n) || n == 0)
+    return 0;
+  struct iovec iov;
+  iov.iov_base = darr->data + (index * darr->size);
+  iov.iov_len  = n * darr->size;
+  size_t total = 0;
+  while (iov.iov_len > 0)
+  {
+    ssize_t wrote = vmsplice(fd, &iov, 1, 0);
+    if (wrote < 0)
+    {
+      if (errno == EINTR ||
+          ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+           __prick_darr_wait_out(fd) == 0))
+        continue;
+      return total ? (ssize_t)total : -1;
+    }
+    total += (size_t)wrote;
+    iov.iov_base = (uint8_t *)iov.iov_base + wrote;
+    iov.iov_len -= (size_t)wrote;
+  }
+  return (ssize_t)total;
+}
+#endif
+#endif
+
+
+static void __prick_darr_inc_migrate(prick_darr_inc_t *inc, size_t n)
+{
+  if (!inc->old)
+    return;
+  prick_darr_t *darr = &inc->darr;
+  n                  = __PRICK_DARR_MIN(n, inc->old_used - inc->migrated);
+  memcpy(darr->data + (inc->migrated * darr->size),
+         inc->old + (inc->migrated * darr->size), n * darr->size);
+#ifdef PRICK_DARR_STATS
+  darr->stats.bytes_copied += n * darr->size;
+  prick_darr_global_stats.total.bytes_copied += n * darr->size;
+#endif
+  inc->migrated += n;
+  if (inc->migrated < inc->old_used)
+    return;
+  if (!inc->old_inline)
+  {
+    __PRICK_DARR_STATS_RESIZE(darr, inc->old_available * darr->size, 0, 0);
+    __prick_darr_dealloc(darr, inc->old, inc->old_available * darr->size);
+  }
+  inc->old = NULL;
+}
+
+void prick_darr_inc_init(prick_darr_inc_t *inc, size_t member_size)
+{
+  if (!inc)
+    return;
+  prick_darr_init(&inc->darr, member_size);
+  inc->old           = NULL;
+  inc->old_available = 0;
+  inc->old_used      = 0;
+  inc->migrated      = 0;
+  inc->old_inline    = 0;
+}
+
+void prick_darr_inc_free(prick_darr_inc_t *inc, void (*mem_free)(void *))
+{
+  if (mem_free)
+    for (size_t i = 0; i < inc->darr.used; ++i)
+      mem_free(prick_darr_inc_at(inc, i));
+  if (inc->old && !inc->old_inline)
+  {
+    __PRICK_DARR_STATS_RESIZE(&inc->darr, inc->old_available * inc->darr.size,
+                              0, 0);
+    __prick_darr_dealloc(&inc->darr, inc->old,
+                         inc->old_available * inc->darr.size);
+  }
+  inc->old = NULL;
+  prick_darr_free(&inc->darr, NULL);
+}
+
+int prick_darr_inc_append(prick_darr_inc_t *inc, void *ptr)
+{
+  prick_darr_t *darr = &inc->darr;
+  if (darr->used == darr->available)
+  {
+    // Growth policies with small steps may outpace migration
+    prick_darr_inc_finish(inc);
+    size_t available = __prick_darr_grow_capacity(darr, 1, 0);
+    if (available < darr->used + 1)
+      return -1;
+    uint8_t *data = __prick_darr_alloc(darr, available * darr->size);
+    // See prick_darr_ensure_capacity
+    if (!data && available > darr->used + 1)
+    {
+      available = darr->used + 1;
+      data      = __prick_darr_alloc(darr, available * darr->size);
+    }
+    if (!data)
+      return -1;
+    available = __prick_darr_usable(darr, data, available, 0);
+    inc->old           = darr->data;
+    inc->old_available = darr->available;
+    inc->old_used      = darr->used;
+    inc->migrated      = 0;
+    inc->old_inline    = (darr->flags & PRICK_DARR_FLAG_INLINE) != 0;
+    darr->data         = data;
+    darr->available    = available;
+    __PRICK_DARR_STATS_RESIZE(darr, 0, available * darr->size, 0);
+    darr->flags &= ~PRICK_DARR_FLAG_INLINE;
+    if (!inc->old_used)
+      // Nothing to migrate so release old storage straight away
+      __prick_darr_inc_migrate(inc, 0);
+  }
+  memcpy(darr->data + (darr->used * darr->size), ptr, darr->size);
+  ++darr->used;
+  __PRICK_DARR_STATS_USE(darr, 1);
+  __prick_darr_inc_migrate(inc, PRICK_DARR_INC_STEP);
+  return 0;
+}
+
+void *prick_darr_inc_at(prick_darr_inc_t *inc, size_t n)
+{
+  if (inc->old && n >= inc->migrated && n < inc->old_used)
+    return inc->old + (n * inc->darr.size);
+  return inc->darr.data + (n * inc->darr.size);
+}
+
+void prick_darr_inc_finish(prick_darr_inc_t *inc)
+{
+  if (inc->old)
+    __prick_darr_inc_migrate(inc, inc->old_used - inc->migrated);
+}
+
+
+void prick_darr_init_stages(prick_darr_t *stages, size_t n,
+                            size_t member_size)
+{
+  for (size_t i = 0; i < n; ++i)
+    prick_darr_init_lazy(stages + i, member_size);
+}
+
+int prick_darr_merge_prepare(prick_darr_t *target, const prick_darr_t *stages,
+                             size_t n, size_t *offsets)
+{
+  size_t total = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    offsets[i] = target->used + total;
+    total += stages[i].used;
+  }
+  if (prick_darr_ensure_capacity(target, total))
+    return -1;
+  // The members move from the staging arrays to the target, so the
+  // global used count doesn't change (and merge_copy, which may run
+  // on several threads, needn't touch it)
+  target->used += total;
+  return 0;
+}
+
+void prick_darr_merge_copy(prick_darr_t *target, prick_darr_t *stage,
+                           size_t offset)
+{
+  if (stage->used)
+    memcpy(target->data + (offset * target->size), stage->data,
+           stage->used * stage->size);
+  stage->used = 0;
+}
+
+#ifdef PRICK_DARR_THREADS
+// Below this many bytes a thread costs more than the copy it does
+#define __PRICK_DARR_MERGE_THREAD_MIN (1 << 20)
+
+typedef struct
+{
+  prick_darr_t *target, *stage;
+  size_t offset;
+} __prick_darr_merge_job_t;
+
+static void *__prick_darr_merge_worker(void *arg)
+{
+  __prick_darr_merge_job_t *job = (__prick_darr_merge_job_t *)arg;
+  prick_darr_merge_copy(job->target, job->stage, job->offset);
+  return NULL;
+}
+#endif
+
+int prick_darr_merge(prick_darr_t *target, prick_darr_t *stages, size_t n)
+{
+  if (n == 0)
+    return 0;
+  size_t *offsets = (size_t *)malloc(n * sizeof(*offsets));
+  if (!offsets || prick_darr_merge_prepare(target, stages, n, offsets))
+  {
+    free(offsets);
+    return -1;
+  }
+#ifdef PRICK_DARR_THREADS
+  __prick_darr_merge_job_t *jobs =
+      (__prick_darr_merge_job_t *)malloc(n * sizeof(*jobs));
+  pthread_t *threads = (pthread_t *)malloc(n * sizeof(*threads));
+  // The calling thread copies the first staging array itself, and all
+  // of them if there's no memory to keep track of threads
+  for (size_t i = 1; i < n && !(jobs && threads); ++i)
+    prick_darr_merge_copy(target, stages + i, offsets[i]);
+  for (size_t i = 1; i < n && jobs && threads; ++i)
+  {
+    jobs[i].target = target;
+    jobs[i].stage  = stages + i;
+    jobs[i].offset = offsets[i];
+    if (stages[i].used * stages[i].size < __PRICK_DARR_MERGE_THREAD_MIN ||
+        pthread_create(threads + i, NULL, __prick_darr_merge_worker,
+                       jobs + i) != 0)
+    {
+      prick_darr_merge_copy(target, stages + i, offsets[i]);
+      jobs[i].stage = NULL;
+    }
+  }
+  prick_darr_merge_copy(target, stages, offsets[0]);
+  for (size_t i = 1; i < n && jobs && threads; ++i)
+    if (jobs[i].stage)
+      pthread_join(threads[i], NULL);
+  free(threads);
+  free(jobs);
+#else
+  for (size_t i = 0; i < n; ++i)
+    prick_darr_merge_copy(target, stages + i, offsets[i]);
+#endif
+  free(offsets);
+  return 0;
+}
+
+void *prick_darr_fat_init(size_t member_size, size_t n)
+{
+  return prick_darr_fat_init_allocator(member_size, n, NULL, NULL);
+}
+
+void *prick_darr_fat_init_allocator(size_t member_size, size_t n,
+                                    const prick_darr_allocator_t *allocator,
+                                    void *ctx)
+{
+  prick_darr_t header;
+  prick_darr_init_lazy(&header, member_size);
+  header.allocator     = allocator;
+  header.allocator_ctx = ctx;
+  n = __prick_darr_size_class(&header, n, PRICK_DARR_FAT_OFFSET);
+  if (__prick_darr_clamp(&header, n, PRICK_DARR_FAT_OFFSET) < n)
+    return NULL;
+  uint8_t *block =
+      __prick_darr_alloc(&header, PRICK_DARR_FAT_OFFSET + (n * member_size));
+  if (!block)
+    return NULL;
+  n = __prick_darr_usable(&header, block, n, PRICK_DARR_FAT_OFFSET);
+  header.data      = block + PRICK_DARR_FAT_OFFSET;
+  header.available = n;
+  __PRICK_DARR_STATS_RESIZE(&header, 0, n * member_size, 0);
+  memcpy(block, &header, sizeof(header));
+  return header.data;
+}
+
+void *prick_darr_fat_grow(void *ptr, size_t member_size, size_t requested)
+{
+  if (!ptr)
+    return prick_darr_fat_init(
+        member_size, __PRICK_DARR_MAX(PRICK_DARR_DEFAULT_SIZE, requested));
+  prick_darr_t *header = PRICK_DARR_FAT(ptr);
+  if (header->used + requested <= header->available)
+    return ptr;
+  size_t old_available = header->available;
+  size_t available     =
+      __prick_darr_grow_capacity(header, requested, PRICK_DARR_FAT_OFFSET);
+  if (available < header->used + requested)
+    return ptr;
+  uint8_t *block = __prick_darr_realloc(
+      header, header, PRICK_DARR_FAT_OFFSET + (old_available * member_size),
+      PRICK_DARR_FAT_OFFSET + (available * member_size));
+  // See prick_darr_ensure_capacity
+  if (!block && available > header->used + requested)
+  {
+    available = header->used + requested;
+    block     = __prick_darr_realloc(
+        header, header, PRICK_DARR_FAT_OFFSET + (old_available * member_size),
+        PRICK_DARR_FAT_OFFSET + (available * member_size));
+  }
+  // The old block is untouched if realloc failed
+  if (!block)
+    return ptr;
+  available = __prick_darr_usable((prick_darr_t *)block, block, available,
+                                  PRICK_DARR_FAT_OFFSET);
+  __PRICK_DARR_STATS_RESIZE((prick_darr_t *)block, old_available * member_size,
+                            available * member_size,
+                            block == (uint8_t *)header
+                                ? 0
+                                : ((prick_darr_t *)block)->used * member_size);
+  header            = (prick_darr_t *)block;
+  header->data      = block + PRICK_DARR_FAT_OFFSET;
+  header->available = available;
+  return header->data;
+}
+
+void *prick_darr_fat_append_n(void *ptr, size_t member_size, const void *src,
+                              size_t n)
+{
+  if (n == 0)
+    return ptr;
+  ptr = prick_darr_fat_grow(ptr, member_size, n);
+  if (!ptr || PRICK_DARR_FAT(ptr)->used + n > PRICK_DARR_FAT(ptr)->available)
+    return ptr;
+  prick_darr_t *header = PRICK_DARR_FAT(ptr);
+  memcpy(header->data + (header->used * member_size), src, n * member_size);
+  header->used += n;
+  __PRICK_DARR_STATS_USE(header, n);
+  return ptr;
+}
+
+void prick_darr_fat_free(void *ptr)
+{
+  if (!ptr)
+    return;
+  prick_darr_t *header = PRICK_DARR_FAT(ptr);
+  __PRICK_DARR_STATS_UNUSE(header, header->used);
+  __PRICK_DARR_STATS_RESIZE(header, header->available * header->size, 0, 0);
+  __prick_darr_dealloc(header, header,
+                       PRICK_DARR_FAT_OFFSET +
+                           (header->available * header->size));
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef PRICK_DARR_PROFILE
+// Defined after the implementation so only callers are profiled
+#define prick_darr_init(DARR, SIZE) \
+  __prick_darr_init_site((DARR), (SIZE), __FILE__, __LINE__)
+#define prick_darr_init_allocator(DARR, SIZE, ALLOCATOR, CTX)              \
+  __prick_darr_init_allocator_site((DARR), (SIZE), (ALLOCATOR), (CTX),     \
+                                   __FILE__, __LINE__)
+#ifdef PRICK_DARR_HAS_ALIGNED
+#define prick_darr_init_aligned(DARR, SIZE, ALIGN) \
+  __prick_darr_init_aligned_site((DARR), (SIZE), (ALIGN), __FILE__, __LINE__)
+#endif
+#ifdef PRICK_DARR_HAS_MMAP
+#define prick_darr_init_vmem(DARR, SIZE, MAX) \
+  __prick_darr_init_vmem_site((DARR), (SIZE), (MAX), __FILE__, __LINE__)
+#define prick_darr_init_file(DARR, SIZE, FD) \
+  __prick_darr_init_file_site((DARR), (SIZE), (FD), __FILE__, __LINE__)
+#endif
+#ifdef PRICK_DARR_HAS_MREMAP
+#define prick_darr_init_mremap(DARR, SIZE, THRESHOLD)                      \
+  __prick_darr_init_mremap_site((DARR), (SIZE), (THRESHOLD), __FILE__,     \
+                                __LINE__)
+#endif
+#define prick_darr_init_lazy(DARR, SIZE) \
+  __prick_darr_init_lazy_site((DARR), (SIZE), __FILE__, __LINE__)
+#define prick_darr_init_inline(DARR, SIZE, BUFFER, MEMBERS)                \
+  __prick_darr_init_inline_site((DARR), (SIZE), (BUFFER), (MEMBERS),       \
+                                __FILE__, __LINE__)
+#define prick_darr_adopt(DARR, SIZE, BUFFER, USED, AVAILABLE)              \
+  __prick_darr_adopt_site((DARR), (SIZE), (BUFFER), (USED), (AVAILABLE),   \
+                          __FILE__, __LINE__)
+#define prick_darr_adopt_allocator(DARR, SIZE, BUFFER, USED, AVAILABLE,    \
+                                   ALLOCATOR, CTX)                         \
+  __prick_darr_adopt_allocator_site((DARR), (SIZE), (BUFFER), (USED),      \
+                                    (AVAILABLE), (ALLOCATOR), (CTX),       \
+                                    __FILE__, __LINE__)
+#define prick_darr_ensure_capacity(DARR, REQUESTED) \
+  __prick_darr_ensure_capacity_site((DARR), (REQUESTED), __FILE__, __LINE__)
+#define prick_darr_append(DARR, PTR) \
+  __prick_darr_append_site((DARR), (PTR), __FILE__, __LINE__)
+#define prick_darr_append_n(DARR, PTR, N) \
+  __prick_darr_append_n_site((DARR), (PTR), (N), __FILE__, __LINE__)
+#define prick_darr_insert_n(DARR, PTR, N, INDEX)                           \
+  __prick_darr_insert_n_site((DARR), (PTR), (N), (INDEX), __FILE__,        \
+                             __LINE__)
+#define prick_darr_insert_many(DARR, PTR, N, INDICES)                      \
+  __prick_darr_insert_many_site((DARR), (PTR), (N), (INDICES), __FILE__,   \
+                                __LINE__)
 #endif
 
 #endif
@@ -0,0 +1,383 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: C++ RAII wrapper over prick_darr_t
+ */
+
+// Like prick_darr.h, define PRICK_DARR_IMPLEMENTATION in exactly one
+// source file (C or C++) before including this header
+
+#ifndef PRICK_DARR_HPP
+#define PRICK_DARR_HPP
+
+#include "prick_darr.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace prick
+{
+  /**
+   * Whether members of type T can be moved in memory by a plain byte
+   * copy (realloc) without running any constructors or destructors.
+   * True for trivially copyable types; specialise it for types which
+   * are safe to relocate but aren't trivially copyable (e.g. types
+   * holding a unique owning pointer).
+   */
+  template <typename T>
+  struct is_trivially_relocatable : std::is_trivially_copyable<T>
+  {
+  };
+
+  /**
+   * Where a darr is constructed, given to its constructors by default
+   * so that with PRICK_DARR_PROFILE arrays are attributed to the code
+   * constructing them rather than to this header.  Empty otherwise.
+   */
+  struct darr_site
+  {
+#ifdef PRICK_DARR_PROFILE
+    const char *file;
+    int line;
+
+    darr_site(const char *caller_file = __builtin_FILE(),
+              int caller_line         = __builtin_LINE())
+        : file(caller_file), line(caller_line)
+    {
+    }
+#endif
+  };
+
+  /**
+   * A prick_darr_t owning members of type T.  Construction and
+   * destruction of members is handled by the wrapper, moving a darr
+   * steals its storage, and iterators are plain pointers.  Growth
+   * goes through prick_darr_ensure_capacity so the allocator and
+   * growth policy of the underlying prick_darr_t are respected; when T
+   * is trivially relocatable that's a single realloc, otherwise
+   * members are move constructed into a fresh block.  If the storage
+   * can't grow, std::bad_alloc is thrown and the darr is left as it
+   * was.
+   */
+  template <typename T>
+  class darr
+  {
+  public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using reference       = T &;
+    using const_reference = const T &;
+    using iterator        = T *;
+    using const_iterator  = const T *;
+
+    darr(darr_site site = darr_site())
+    {
+      init_empty(site);
+    }
+
+    darr(const prick_darr_allocator_t *allocator, void *ctx,
+         darr_site site = darr_site())
+    {
+      init_empty(site);
+      m_darr.allocator     = allocator;
+      m_darr.allocator_ctx = ctx;
+    }
+
+    darr(std::initializer_list<T> init, darr_site site = darr_site())
+        : darr(site)
+    {
+      reserve(init.size());
+      for (const T &x : init)
+        push_back(x);
+    }
+
+    darr(const darr &other, darr_site site = darr_site())
+        : darr(other.m_darr.allocator, other.m_darr.allocator_ctx, site)
+    {
+      m_darr.growth = other.m_darr.growth;
+      reserve(other.size());
+      for (const T &x : other)
+        push_back(x);
+    }
+
+    darr(darr &&other) noexcept : m_darr(other.m_darr)
+    {
+      other.reset_empty();
+    }
+
+    darr &operator=(const darr &other)
+    {
+      if (this != &other)
+      {
+        darr copy(other);
+        swap(copy);
+      }
+      return *this;
+    }
+
+    darr &operator=(darr &&other) noexcept
+    {
+      if (this != &other)
+      {
+        destroy();
+        m_darr = other.m_darr;
+        other.reset_empty();
+      }
+      return *this;
+    }
+
+    ~darr()
+    {
+      destroy();
+    }
+
+    void swap(darr &other) noexcept
+    {
+      std::swap(m_darr, other.m_darr);
+    }
+
+    /**
+     * Ensures capacity for at least n members in total.
+     */
+    void reserve(size_type n)
+    {
+      if (n > capacity())
+        grow(n - m_darr.used);
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args &&...args)
+    {
+      if (m_darr.used == m_darr.available)
+      {
+        // args may refer to a member (e.g. push_back(v[0])), so make
+        // the element before growth releases the old storage
+        T value(std::forward<Args>(args)...);
+        grow(1);
+        T *slot = new (data() + m_darr.used) T(std::move(value));
+        ++m_darr.used;
+        __PRICK_DARR_STATS_USE(&m_darr, 1);
+        return *slot;
+      }
+      T *slot = new (data() + m_darr.used) T(std::forward<Args>(args)...);
+      ++m_darr.used;
+      __PRICK_DARR_STATS_USE(&m_darr, 1);
+      return *slot;
+    }
+
+    void push_back(const T &x)
+    {
+      emplace_back(x);
+    }
+
+    void push_back(T &&x)
+    {
+      emplace_back(std::move(x));
+    }
+
+    void pop_back()
+    {
+      --m_darr.used;
+      data()[m_darr.used].~T();
+      __PRICK_DARR_STATS_UNUSE(&m_darr, 1);
+    }
+
+    void clear()
+    {
+      for (size_type i = 0; i < m_darr.used; ++i)
+        data()[i].~T();
+      __PRICK_DARR_STATS_UNUSE(&m_darr, m_darr.used);
+      m_darr.used = 0;
+    }
+
+    void shrink_to_fit()
+    {
+      if (is_trivially_relocatable<T>::value)
+        prick_darr_tighten(&m_darr);
+    }
+
+    T *data()
+    {
+      return reinterpret_cast<T *>(m_darr.data);
+    }
+
+    const T *data() const
+    {
+      return reinterpret_cast<const T *>(m_darr.data);
+    }
+
+    size_type size() const
+    {
+      return m_darr.used;
+    }
+
+    size_type capacity() const
+    {
+      return m_darr.available;
+    }
+
+    bool empty() const
+    {
+      return m_darr.used == 0;
+    }
+
+    T &operator[](size_type n)
+    {
+      return data()[n];
+    }
+
+    const T &operator[](size_type n) const
+    {
+      return data()[n];
+    }
+
+    T &front()
+    {
+      return data()[0];
+    }
+
+    T &back()
+    {
+      return data()[m_darr.used - 1];
+    }
+
+    iterator begin()
+    {
+      return data();
+    }
+
+    iterator end()
+    {
+      return data() + m_darr.used;
+    }
+
+    const_iterator begin() const
+    {
+      return data();
+    }
+
+    const_iterator end() const
+    {
+      return data() + m_darr.used;
+    }
+
+    /**
+     * The underlying dynamic array, for use with the C API.  Anything
+     * that changes the members (other than through trivial byte
+     * copies) must keep them correctly constructed.
+     */
+    prick_darr_t &raw()
+    {
+      return m_darr;
+    }
+
+  private:
+    prick_darr_t m_darr;
+
+    // The C API's profiling macros would attribute arrays to this
+    // header, hence the parenthesised calls
+    void init_empty(darr_site site)
+    {
+      (prick_darr_init_lazy)(&m_darr, sizeof(T));
+#ifdef PRICK_DARR_PROFILE
+      __prick_darr_claim(&m_darr, site.file, site.line);
+#else
+      (void)site;
+#endif
+    }
+
+    void reset_empty()
+    {
+      const prick_darr_allocator_t *allocator = m_darr.allocator;
+      void *ctx                               = m_darr.allocator_ctx;
+      const prick_darr_growth_t *growth       = m_darr.growth;
+      (prick_darr_init_lazy)(&m_darr, sizeof(T));
+      m_darr.allocator     = allocator;
+      m_darr.allocator_ctx = ctx;
+      m_darr.growth        = growth;
+    }
+
+    void destroy()
+    {
+      // Members are left counted as used so prick_darr_free records
+      // the final size with PRICK_DARR_PROFILE
+      for (size_type i = 0; i < m_darr.used; ++i)
+        data()[i].~T();
+      prick_darr_free(&m_darr, NULL);
+    }
+
+    // Gives a block straight back to the allocator, without counting
+    // it as freed in PRICK_DARR_STATS or PRICK_DARR_PROFILE
+    static void release(prick_darr_t &darr)
+    {
+      if (!darr.data || (darr.flags & PRICK_DARR_FLAG_INLINE))
+        return;
+      if (darr.allocator)
+        darr.allocator->free(darr.allocator_ctx, darr.data,
+                             darr.available * darr.size);
+      else
+        std::free(darr.data);
+    }
+
+    void grow(size_type requested)
+    {
+      if (m_darr.used + requested <= m_darr.available)
+        return;
+      if (is_trivially_relocatable<T>::value)
+      {
+        if ((prick_darr_ensure_capacity)(&m_darr, requested))
+          throw std::bad_alloc();
+        return;
+      }
+
+      // Detach the storage so ensure_capacity makes a fresh block with
+      // the capacity the growth policy asks for (counting the resize in
+      // PRICK_DARR_STATS).  The old capacity is kept for the policy,
+      // which is fine as the array is known to be full.
+      prick_darr_t next = m_darr;
+      next.data         = NULL;
+      next.flags        = 0;
+      if ((prick_darr_ensure_capacity)(&next, requested))
+        throw std::bad_alloc();
+
+      // Construct every member in the new block before destroying any
+      // of the old ones, so a throwing copy leaves the darr as it was
+      T *from     = data();
+      T *to       = reinterpret_cast<T *>(next.data);
+      size_type i = 0;
+      try
+      {
+        for (; i < m_darr.used; ++i)
+          new (to + i) T(std::move_if_noexcept(from[i]));
+      }
+      catch (...)
+      {
+        while (i > 0)
+          to[--i].~T();
+        release(next);
+#ifdef PRICK_DARR_STATS
+        prick_darr_global_stats.available -=
+            (next.available - m_darr.available) * m_darr.size;
+#endif
+        throw;
+      }
+      for (i = 0; i < m_darr.used; ++i)
+        from[i].~T();
+      // The array lives on in next, so the old block mustn't be
+      // counted as freed
+      release(m_darr);
+      m_darr = next;
+    }
+  };
+} // namespace prick
+
+#endif
@@ -0,0 +1,407 @@
+/* Copyright (C) 2026 agent
+
+ * You may distribute and modify this code under the terms of the MIT
+ * license.  You should have received a copy of the MIT license with
+ * this file.  If not, please write to: agent@local.
+
+ * Created: 2026-10-16
+ * Author: agent
+ * Description: A type homogeneous segmented array with stable member
+ * addresses
+ */
+
+#ifndef PRICK_SARR_H
+#define PRICK_SARR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Log2 of the number of members in the first chunk
+#define PRICK_SARR_FIRST_CHUNK_LOG2 3
+#define PRICK_SARR_FIRST_CHUNK      (1 << PRICK_SARR_FIRST_CHUNK_LOG2)
+// Chunk k holds PRICK_SARR_FIRST_CHUNK << k members
+#define PRICK_SARR_MAX_CHUNKS 40
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PRICK_SARR_HAS_ATOMIC
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Members are stored in chunks of geometrically growing size which
+ * are never moved once allocated, so growth only costs the allocation
+ * of a new chunk and pointers to members stay valid for the lifetime
+ * of the array.
+ */
+typedef struct
+{
+  size_t size;      // size of each "member"
+  size_t used;      // number of elements currently used
+  size_t available; // number of elements allocated
+  uint8_t *chunks[PRICK_SARR_MAX_CHUNKS];
+} prick_sarr_t;
+
+/**
+ * UNSAFE!
+ *
+ * Gets NTH member of SARR, casting result to TYPE.  Does no bounds
+ * checking and relies on runtime to cast correctly.  Only use when
+ * sure that the segmented array is well formed for this.
+ *
+ * @param SARR: Segmented array to get member from
+ *
+ * @param TYPE: Type to cast member to
+ *
+ * @param N: Index of member
+ */
+#define PRICK_SARR_AT(SARR, TYPE, N) (*(TYPE *)prick_sarr_at(&(SARR), (N)))
+
+/**
+ * Initialises the segmented array given.  Nothing is allocated until
+ * the first member is added.
+ *
+ * @param prick_sarr_t *: Segmented array to initialise
+ *
+ * @param size_t: Size of member type in bytes
+ */
+void prick_sarr_init(prick_sarr_t *, size_t);
+
+/**
+ * Frees the memory associated with segmented array, using the object
+ * free function given to free each member before freeing the chunks.
+ * If the free function is NULL, then only the chunks are freed.
+ *
+ * @param prick_sarr_t *: Segmented array to free
+ *
+ * @param void (*)(void *): Member freeing function (can be NULL)
+ */
+void prick_sarr_free(prick_sarr_t *, void (*)(void *));
+
+/**
+ * Gets a pointer to the Nth member of the segmented array in O(1).
+ * Does no bounds checking, but returns NULL if the chunk holding the
+ * member is missing (see prick_sarr_append_atomic).
+ *
+ * @param prick_sarr_t *: Segmented array to index
+ *
+ * @param size_t: Index of member
+ */
+void *prick_sarr_at(prick_sarr_t *, size_t);
+
+/**
+ * Ensures there's enough capacity available for the size requested in
+ * the given segmented array, allocating chunks as needed.  Existing
+ * members are never moved.  Returns 0, or -1 if a chunk couldn't be
+ * allocated, in which case prick_sarr_t.available is left as it was
+ * (chunks already allocated are kept for the next attempt).  Chunks
+ * missing below prick_sarr_t.used after failed atomic appends are
+ * allocated too, so requesting 0 members repairs the array.
+ *
+ * @param prick_sarr_t *: Segmented array to check
+ *
+ * @param size_t: Number of members requested
+ */
+int prick_sarr_ensure_capacity(prick_sarr_t *, size_t);
+
+/**
+ * Appends the element (at pointer) to the segmented array.  Assumes
+ * element is of the same type as the members of the segmented array
+ * (hence has the same size in bytes as prick_sarr_t.size).  Returns
+ * 0, or -1 if the segmented array couldn't grow (see
+ * prick_sarr_ensure_capacity), in which case nothing is appended.
+ *
+ * @param prick_sarr_t *: Segmented array to append to
+ *
+ * @param void *: (Pointer to) element to append
+ */
+int prick_sarr_append(prick_sarr_t *, void *);
+
+/**
+ * Appends array of n elements (referred by pointer) to the segmented
+ * array.  Assumes each element is of the same type as the members of
+ * the segmented array (hence has the same size in bytes as
+ * prick_sarr_t.size).  Returns 0, or -1 if the segmented array
+ * couldn't grow, in which case nothing is appended.
+ *
+ * @param prick_sarr_t *: Segmented array to append to
+ *
+ * @param void *: (Pointer to) array of elements to append
+ *
+ * @param size_t: Number of elements in array to append
+ */
+int prick_sarr_append_n(prick_sarr_t *, void *, size_t);
+
+/**
+ * Writes the element (at pointer) at a specific position in the
+ * segmented array.  Will stop if position is out of bounds i.e. more
+ * than number of used elements, or if its chunk is missing.
+ *
+ * @param prick_sarr_t *: Segmented array to insert in
+ *
+ * @param void *: (Pointer to) element to insert
+ *
+ * @param size_t: Index where to write element
+ */
+void prick_sarr_write(prick_sarr_t *, void *, size_t);
+
+/**
+ * Writes array of n elements (referred by pointer) at a specific
+ * position in the segmented array.  Will stop if position is out of
+ * bounds, or if position + number of elements is out of bounds
+ * i.e. more than number of used elements, or if any of their chunks
+ * are missing.
+ *
+ * @param prick_sarr_t *: Segmented array to write to
+ *
+ * @param void *: (Pointer to) array of elements to write
+ *
+ * @param size_t: Number of elements in array to write
+ *
+ * @param size_t: Index where to start overwriting elements
+ */
+void prick_sarr_write_n(prick_sarr_t *, void *, size_t, size_t);
+
+#ifdef PRICK_SARR_HAS_ATOMIC
+/**
+ * Appends the element (at pointer) to the segmented array, safe to
+ * call from many threads at once without locks.  A slot is reserved
+ * with an atomic increment of prick_sarr_t.used and written in place;
+ * missing chunks are installed with a compare and swap, so growth
+ * never blocks other appenders or readers.  Returns the index the
+ * element was written to, which is only safe for other threads to
+ * read once they've synchronised with the appender (e.g. by joining
+ * it).  Must not be mixed with the other (non-atomic) functions that
+ * change the array at the same time.
+ *
+ * Returns (size_t)-1 if the chunk for the slot couldn't be allocated.
+ * The slot stays reserved (counted in prick_sarr_t.used) but has no
+ * storage behind it: prick_sarr_at gives NULL for it (PRICK_SARR_AT
+ * must not be used on it) and writes to it are ignored.  Once the
+ * appenders are done, prick_sarr_ensure_capacity(sarr, 0) allocates
+ * the missing chunks, after which such slots are valid but hold
+ * unspecified contents; prick_sarr_free skips them either way.
+ *
+ * @param prick_sarr_t *: Segmented array to append to
+ *
+ * @param void *: (Pointer to) element to append
+ */
+size_t prick_sarr_append_atomic(prick_sarr_t *, void *);
+
+/**
+ * Appends array of n elements (referred by pointer) to the segmented
+ * array as one contiguous range of indices, safe to call from many
+ * threads at once.  Returns the index of the first element, or
+ * (size_t)-1 if a chunk couldn't be allocated, in which case none of
+ * the range is written.  See prick_sarr_append_atomic.
+ *
+ * @param prick_sarr_t *: Segmented array to append to
+ *
+ * @param void *: (Pointer to) array of elements to append
+ *
+ * @param size_t: Number of elements in array to append
+ */
+size_t prick_sarr_append_n_atomic(prick_sarr_t *, void *, size_t);
+#endif
+
+// Define PRICK_SARR_IMPLEMENTATION in exactly one source file
+#ifdef PRICK_SARR_IMPLEMENTATION
+
+#define __PRICK_SARR_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+static size_t __prick_sarr_msb(size_t n)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return (sizeof(unsigned long long) * 8 - 1) -
+         (size_t)__builtin_clzll((unsigned long long)n);
+#else
+  size_t msb = 0;
+  while (n >>= 1)
+    ++msb;
+  return msb;
+#endif
+}
+
+// Chunk holding index
+static size_t __prick_sarr_chunk(size_t index)
+{
+  return __prick_sarr_msb(index + PRICK_SARR_FIRST_CHUNK) -
+         PRICK_SARR_FIRST_CHUNK_LOG2;
+}
+
+// Index of the first member of chunk k
+static size_t __prick_sarr_chunk_start(size_t k)
+{
+  return ((size_t)PRICK_SARR_FIRST_CHUNK << k) - PRICK_SARR_FIRST_CHUNK;
+}
+
+static size_t __prick_sarr_chunk_members(size_t k)
+{
+  return (size_t)PRICK_SARR_FIRST_CHUNK << k;
+}
+
+void prick_sarr_init(prick_sarr_t *sarr, size_t member_size)
+{
+  if (!sarr)
+    return;
+  memset(sarr, 0, sizeof(*sarr));
+  sarr->size = member_size;
+}
+
+void prick_sarr_free(prick_sarr_t *sarr, void (*mem_free)(void *))
+{
+  // Slots of failed atomic appends may have no chunk behind them
+  if (mem_free)
+    for (size_t i = 0; i < sarr->used; ++i)
+    {
+      void *member = prick_sarr_at(sarr, i);
+      if (member)
+        mem_free(member);
+    }
+  for (size_t k = 0; k < PRICK_SARR_MAX_CHUNKS; ++k)
+    free(sarr->chunks[k]);
+}
+
+void *prick_sarr_at(prick_sarr_t *sarr, size_t n)
+{
+  size_t k = __prick_sarr_chunk(n);
+  if (!sarr->chunks[k])
+    return NULL;
+  return sarr->chunks[k] + ((n - __prick_sarr_chunk_start(k)) * sarr->size);
+}
+
+int prick_sarr_ensure_capacity(prick_sarr_t *sarr, size_t requested)
+{
+  size_t available = sarr->available;
+  while (sarr->used + requested > available)
+  {
+    size_t k = __prick_sarr_chunk(available);
+    if (k >= PRICK_SARR_MAX_CHUNKS)
+      return -1;
+    // Atomic appends install chunks without touching available
+    if (!sarr->chunks[k])
+    {
+      sarr->chunks[k] =
+          (uint8_t *)malloc(__prick_sarr_chunk_members(k) * sarr->size);
+      if (!sarr->chunks[k])
+        return -1;
+    }
+    available += __prick_sarr_chunk_members(k);
+  }
+  sarr->available = available;
+  return 0;
+}
+
+int prick_sarr_append(prick_sarr_t *sarr, void *ptr)
+{
+  if (prick_sarr_ensure_capacity(sarr, 1))
+    return -1;
+  memcpy(prick_sarr_at(sarr, sarr->used), ptr, sarr->size);
+  ++sarr->used;
+  return 0;
+}
+
+// Copies n members from ptr into the array starting at index, one
+// chunk at a time
+static void __prick_sarr_copy(prick_sarr_t *sarr, uint8_t *ptr, size_t n,
+                              size_t index)
+{
+  while (n > 0)
+  {
+    size_t k     = __prick_sarr_chunk(index);
+    size_t start = __prick_sarr_chunk_start(k);
+    size_t count =
+        __PRICK_SARR_MIN(n, __prick_sarr_chunk_members(k) - (index - start));
+    memcpy(sarr->chunks[k] + ((index - start) * sarr->size), ptr,
+           count * sarr->size);
+    ptr += count * sarr->size;
+    index += count;
+    n -= count;
+  }
+}
+
+int prick_sarr_append_n(prick_sarr_t *sarr, void *ptr, size_t n)
+{
+  if (prick_sarr_ensure_capacity(sarr, n))
+    return -1;
+  __prick_sarr_copy(sarr, (uint8_t *)ptr, n, sarr->used);
+  sarr->used += n;
+  return 0;
+}
+
+void prick_sarr_write(prick_sarr_t *sarr, void *ptr, size_t index)
+{
+  void *member = sarr->used <= index ? NULL : prick_sarr_at(sarr, index);
+  if (!member)
+    return;
+  memcpy(member, ptr, sarr->size);
+}
+
+void prick_sarr_write_n(prick_sarr_t *sarr, void *ptr, size_t n, size_t index)
+{
+  if (sarr->used < (n + index) || n == 0)
+    return;
+  for (size_t k = __prick_sarr_chunk(index),
+              last = __prick_sarr_chunk(index + n - 1);
+       k <= last; ++k)
+    if (!sarr->chunks[k])
+      return;
+  __prick_sarr_copy(sarr, (uint8_t *)ptr, n, index);
+}
+
+#ifdef PRICK_SARR_HAS_ATOMIC
+// Makes sure chunk k exists, racing any other thread to install it.
+// Returns 0, or -1 if it doesn't and couldn't be allocated.
+static int __prick_sarr_install_chunk(prick_sarr_t *sarr, size_t k)
+{
+  if (k >= PRICK_SARR_MAX_CHUNKS)
+    return -1;
+  if (__atomic_load_n(&sarr->chunks[k], __ATOMIC_ACQUIRE))
+    return 0;
+  uint8_t *chunk =
+      (uint8_t *)malloc(__prick_sarr_chunk_members(k) * sarr->size);
+  // Another thread may still have installed it in the meantime
+  if (!chunk)
+    return __atomic_load_n(&sarr->chunks[k], __ATOMIC_ACQUIRE) ? 0 : -1;
+  uint8_t *expected = NULL;
+  if (!__atomic_compare_exchange_n(&sarr->chunks[k], &expected, chunk, 0,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    free(chunk);
+  return 0;
+}
+
+size_t prick_sarr_append_atomic(prick_sarr_t *sarr, void *ptr)
+{
+  size_t index = __atomic_fetch_add(&sarr->used, 1, __ATOMIC_RELAXED);
+  if (__prick_sarr_install_chunk(sarr, __prick_sarr_chunk(index)))
+    return (size_t)-1;
+  memcpy(prick_sarr_at(sarr, index), ptr, sarr->size);
+  return index;
+}
+
+size_t prick_sarr_append_n_atomic(prick_sarr_t *sarr, void *ptr, size_t n)
+{
+  if (n == 0)
+    return __atomic_load_n(&sarr->used, __ATOMIC_RELAXED);
+  size_t index = __atomic_fetch_add(&sarr->used, n, __ATOMIC_RELAXED);
+  for (size_t k = __prick_sarr_chunk(index),
+              last = __prick_sarr_chunk(index + n - 1);
+       k <= last; ++k)
+    if (__prick_sarr_install_chunk(sarr, k))
+      return (size_t)-1;
+  __prick_sarr_copy(sarr, (uint8_t *)ptr, n, index);
+  return index;
+}
+#endif
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif